@@ -5,25 +5,37 @@
 #include "EuresysFrameGrabber.hpp"
 #endif //FORCE_STUB_FRAMEGRABBER_ONLY
 #include "StubFrameGrabber.hpp"
+#include "RawFrameGrabber.hpp"
+#include "SyntheticFrameGrabber.hpp"
 
 #include "ProcessFrameTask.hpp"
+#include "LossLedger.hpp"
 
 #include <glog/logging.h>
 
 namespace fort {
 namespace artemis {
 
-FrameGrabber::Ptr AcquisitionTask::LoadFrameGrabber(const std::vector<std::string> & stubImagePaths,
-                                                    const CameraOptions & options) {
+FrameGrabber::Ptr AcquisitionTask::LoadFrameGrabber(const Options & options) {
+	const auto & general = options.General;
+	if ( general.RawReplayPath.empty() == false ) {
+		return std::make_shared<RawFrameGrabber>(general.RawReplayPath,
+		                                         !general.ReplayAsFastAsPossible);
+	}
+	if ( options.Synthetic.Tags > 0 ) {
+		return std::make_shared<SyntheticFrameGrabber>(options.Synthetic,
+		                                               options.Apriltag.Family,
+		                                               options.Camera.FPS);
+	}
 #ifndef FORCE_STUB_FRAMEGRABBER_ONLY
-	if (stubImagePaths.empty() ) {
+	if (general.StubImagePaths.empty() ) {
 		static Euresys::EGenTL egentl;
-		return std::make_shared<EuresysFrameGrabber>(egentl,options);
+		return std::make_shared<EuresysFrameGrabber>(egentl,options.Camera);
 	} else {
-		return std::make_shared<StubFrameGrabber>(stubImagePaths,options.FPS);
+		return std::make_shared<StubFrameGrabber>(general.StubImagePaths,options.Camera.FPS);
 	}
 #else
-	return std::make_shared<StubFrameGrabber>(stubImagePaths,options.FPS);
+	return std::make_shared<StubFrameGrabber>(general.StubImagePaths,options.Camera.FPS);
 #endif
 }
 
@@ -31,8 +43,14 @@ FrameGrabber::Ptr AcquisitionTask::LoadFrameGrabber(const std::vector<std::strin
 AcquisitionTask::AcquisitionTask(const FrameGrabber::Ptr & grabber,
                                  const ProcessFrameTaskPtr &  process)
 	: d_grabber(grabber)
-	, d_processFrame(process) {
+	, d_processFrame(process)
+	, d_checkFrameID(grabber->ContiguousFrameIDs())
+	, d_lastID(0)
+	, d_hasLastID(false) {
 	d_quit.store(false);
+	if ( d_processFrame ) {
+		d_lossLedger = d_processFrame->LossLedger();
+	}
 }
 
 AcquisitionTask::~AcquisitionTask() { }
@@ -46,6 +64,11 @@ void AcquisitionTask::Run() {
 	d_grabber->Start();
 	while(d_quit.load() == false ) {
 		Frame::Ptr f = d_grabber->NextFrame();
+		if ( !f ) {
+			LOG(INFO) << "[AcquisitionTask]: end of frame stream";
+			break;
+		}
+		CheckFrameID(f->ID());
 		if ( d_processFrame ) {
 			d_processFrame->QueueFrame(f);
 		}
@@ -58,6 +81,22 @@ void AcquisitionTask::Run() {
 	LOG(INFO) << "[AcquisitionTask]:  ended";
 }
 
+void AcquisitionTask::CheckFrameID(uint64_t ID) {
+	if ( d_checkFrameID == false ) {
+		return;
+	}
+	if ( d_hasLastID == true && ID > d_lastID + 1 ) {
+		size_t missing = ID - d_lastID - 1;
+		LOG(WARNING) << "[AcquisitionTask]: " << missing
+		             << " frame(s) missing between " << d_lastID << " and " << ID;
+		if ( d_lossLedger ) {
+			d_lossLedger->RecordGap(LossLedger::Stage::Acquisition,d_lastID + 1,missing,"frame ID gap");
+		}
+	}
+	d_lastID = ID;
+	d_hasLastID = true;
+}
+
 
 } // namespace artemis
 } // namespace fort
@@ -13,12 +13,13 @@ namespace artemis {
 
 class ProcessFrameTask;
 typedef std::shared_ptr<ProcessFrameTask> ProcessFrameTaskPtr;
+class LossLedger;
+typedef std::shared_ptr<LossLedger> LossLedgerPtr;
 
 
 class AcquisitionTask : public Task {
 public:
-	static FrameGrabber::Ptr LoadFrameGrabber(const std::vector<std::string> & stubImagePaths,
-	                                          const CameraOptions & options);
+	static FrameGrabber::Ptr LoadFrameGrabber(const Options & options);
 
 	AcquisitionTask(const FrameGrabber::Ptr & grabber,
 	                const ProcessFrameTaskPtr &  process);
@@ -30,10 +31,17 @@ public:
 	void Stop();
 
 private:
+	// reports the frames missing between two consecutive ones, if
+	// the grabber has contiguous frame IDs.
+	void CheckFrameID(uint64_t ID);
 
 	FrameGrabber::Ptr   d_grabber;
 	ProcessFrameTaskPtr d_processFrame;
 	std::atomic<bool>   d_quit;
+	LossLedgerPtr       d_lossLedger;
+	const bool          d_checkFrameID;
+	uint64_t            d_lastID;
+	bool                d_hasLastID;
 };
 
 } // namespace artemis
@@ -7,14 +7,21 @@
 
 #include <opencv2/core.hpp>
 
+#include <boost/asio/post.hpp>
+
 #include <artemis-config.h>
 
 #include "AcquisitionTask.hpp"
 #include "ProcessFrameTask.hpp"
 #include "FullFrameExportTask.hpp"
+#include "RawFrameRecorderTask.hpp"
 #include "VideoOutputTask.hpp"
 #include "UserInterfaceTask.hpp"
 
+#include "utils/RealTime.hpp"
+
+#include <sched.h>
+
 namespace fort {
 namespace artemis {
 
@@ -39,8 +46,7 @@ bool Application::InterceptCommand(const Options & options ) {
 	}
 
 	if ( options.General.PrintResolution == true ) {
-		auto resolution = AcquisitionTask::LoadFrameGrabber(options.General.StubImagePaths,
-		                                                    options.Camera)->Resolution();
+		auto resolution = AcquisitionTask::LoadFrameGrabber(options)->Resolution();
 		std::cout << resolution.width << " " << resolution.height << std::endl;
 		return true;
 	}
@@ -71,50 +77,110 @@ void Application::InitGoogleLogging(char * applicationName,
 void Application::InitGlobalDependencies() {
 	// Needed as we will do some parallelized access to Eigen ??
 	Eigen::initParallel();
-	// reduce the number of threads for OpenCV to allow some room for
-	// other task (Display & IO)
-	auto numThreads = cv::getNumThreads();
-	if ( numThreads == 2 ) {
-		numThreads = 1;
-	} else if ( numThreads > 2 ) {
-		numThreads -= 2;
-	}
-	cv::setNumThreads(numThreads);
 }
 
 
 Application::Application(const Options & options)
 	: d_signals(d_context,SIGINT)
-	, d_guard(d_context.get_executor()) {
-
-	d_grabber = AcquisitionTask::LoadFrameGrabber(options.General.StubImagePaths,
-	                                              options.Camera);
-
-	d_process = std::make_shared<ProcessFrameTask>(options,
-	                                               d_context,
-	                                               d_grabber->Resolution());
-
-
-	d_acquisition = std::make_shared<AcquisitionTask>(d_grabber,d_process);
+	, d_guard(d_context.get_executor())
+	, d_placement(GetCoreMap(),options.Placement,options.Camera.Count)
+	, d_acquisitionRealTime()
+	, d_processRealTime() {
+	LOG(INFO) << "Thread placement: " << d_placement.Describe();
+
+	SetUpRealTime(options.RealTime);
+
+	// detection threads use the pinned CPUs, or leave room for the
+	// other tasks.
+	size_t threads = d_placement.CPUs(ThreadPlacement::Role::Detection).size();
+	if ( threads == 0 ) {
+		threads = ThreadBudget::DefaultTotal();
+	}
+	d_budget = std::make_shared<ThreadBudget>(threads);
+	// before any work runs in the arenas.
+	d_budget->PinWorkers(d_placement);
+	// OpenCV parallel regions use their own arena, bound to the same
+	// number of threads.
+	cv::setNumThreads(int(d_budget->DetectionThreads()));
+	LOG(INFO) << "Thread budget: " << d_budget->DetectionThreads() << " for detection, "
+	          << d_budget->BackgroundThreads() << " for cataloguing";
+
+	// All detectors share the detection arena of the budget, which
+	// splits its threads between the cameras that have detection
+	// work, instead of each camera sizing its own pool for the whole
+	// host.
+	for ( size_t i = 0; i < options.Camera.Count; ++i ) {
+		auto cameraOptions = options.ForCamera(i);
+		auto grabber = AcquisitionTask::LoadFrameGrabber(cameraOptions);
+		auto process = std::make_shared<ProcessFrameTask>(cameraOptions,
+		                                                  d_context,
+		                                                  grabber->Resolution(),
+		                                                  d_budget);
+		d_grabbers.push_back(grabber);
+		d_processes.push_back(process);
+		d_acquisitions.push_back(std::make_shared<AcquisitionTask>(grabber,process));
+		if ( options.Camera.Count > 1 ) {
+			LOG(INFO) << "Camera " << i << ": readouts on port " << cameraOptions.Network.Port;
+		}
+	}
 }
 
 
-void Application::SpawnTasks() {
-	if ( d_process->FullFrameExportTask() ) {
-		d_threads.push_back(Task::Spawn(*d_process->FullFrameExportTask(),20));
+void Application::SetUpRealTime(const RealTimeOptions & options) {
+	if ( options.Enabled() == false ) {
+		return;
 	}
+	int policy = options.Policy == RealTimeOptions::SchedulingPolicy::RoundRobin ? SCHED_RR : SCHED_FIFO;
+	d_acquisitionRealTime = {.Policy = policy, .Priority = options.AcquisitionPriority};
+	d_processRealTime = {.Policy = policy, .Priority = options.ProcessPriority};
 
-	if ( d_process->VideoOutputTask() ) {
-		d_threads.push_back(Task::Spawn(*d_process->VideoOutputTask(),0));
+	if ( options.NoMemoryLock == true ) {
+		return;
 	}
-
-	if ( d_process->UserInterfaceTask() ) {
-		d_threads.push_back(Task::Spawn(*d_process->UserInterfaceTask(),1));
+	// done before the frame pools are allocated, so they are
+	// prefaulted and locked as well.
+	try {
+		LockProcessMemory();
+		LOG(INFO) << "Memory locked for real-time threads";
+	} catch ( const std::system_error & e ) {
+		LOG(WARNING) << "Could not lock memory, real-time threads may wait on page faults: "
+		             << e.what();
 	}
+}
 
-	d_threads.push_back(Task::Spawn(*d_process,0));
+void Application::SpawnTasks() {
+	typedef ThreadPlacement::Role Role;
+	for ( const auto & process : d_processes ) {
+		if ( process->FullFrameExportTask() ) {
+			d_threads.push_back(Task::Spawn(*process->FullFrameExportTask(),20,
+			                                d_placement.CPUs(Role::Background)));
+		}
+
+		if ( process->RawFrameRecorderTask() ) {
+			d_threads.push_back(Task::Spawn(*process->RawFrameRecorderTask(),5,
+			                                d_placement.CPUs(Role::Background)));
+		}
+
+		if ( process->VideoOutputTask() ) {
+			d_threads.push_back(Task::Spawn(*process->VideoOutputTask(),0,
+			                                d_placement.CPUs(Role::VideoOutput)));
+		}
+
+		if ( process->UserInterfaceTask() ) {
+			d_threads.push_back(Task::Spawn(*process->UserInterfaceTask(),1,
+			                                d_placement.CPUs(Role::UserInterface)));
+		}
+
+		d_threads.push_back(Task::Spawn(*process,0,
+		                                d_placement.CPUs(Role::Processing),
+		                                d_processRealTime));
+	}
 
-	d_threads.push_back(Task::Spawn(*d_acquisition,0));
+	for ( const auto & acquisition : d_acquisitions ) {
+		d_threads.push_back(Task::Spawn(*acquisition,0,
+		                                d_placement.CPUs(Role::Acquisition),
+		                                d_acquisitionRealTime));
+	}
 }
 
 void Application::JoinTasks() {
@@ -124,6 +190,8 @@ void Application::JoinTasks() {
 	}
 	// now, nobody will post IO operation. we can reset safely.
 	d_guard.reset();
+	// the frame stream may have ended by itself, without SIGINT.
+	boost::asio::post(d_context,[this]() { d_signals.cancel(); });
 	// we join the IO thread
 	d_ioThread.join();
 }
@@ -131,14 +199,24 @@ void Application::JoinTasks() {
 void Application::SpawnIOContext() {
 	// putting a wait on SIGINT will ensure that the context remains
 	// active throughout execution.
-	d_signals.async_wait([this](const boost::system::error_code &,
+	d_signals.async_wait([this](const boost::system::error_code & ec,
 	                            int ) {
+		                     if ( ec == boost::asio::error::operation_aborted ) {
+			                     return;
+		                     }
 		                     LOG(INFO) << "Terminating (SIGINT)";
-		                     d_acquisition->Stop();
+		                     for ( const auto & acquisition : d_acquisitions ) {
+			                     acquisition->Stop();
+		                     }
 	                     });
 	// starts the context in a single threads, and remind to join it
 	// once we got the SIGINT
 	d_ioThread = std::thread([this]() {
+		                         try {
+			                         ThreadPlacement::PinCurrentThread(d_placement.CPUs(ThreadPlacement::Role::IO));
+		                         } catch ( const std::exception & e ) {
+			                         LOG(WARNING) << "[IOTask]: could not pin thread: " << e.what();
+		                         }
 		                         LOG(INFO) << "[IOTask]: started";
 		                         d_context.run();
 		                         LOG(INFO) << "[IOTask]: ended";
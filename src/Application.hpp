@@ -2,6 +2,8 @@
 
 #include "Options.hpp"
 #include  "Task.hpp"
+#include "ThreadPlacement.hpp"
+#include "ThreadBudget.hpp"
 
 #include <memory>
 #include <vector>
@@ -34,6 +36,8 @@ private :
 
 	void Run();
 
+	void SetUpRealTime(const RealTimeOptions & options);
+
 	void SpawnIOContext();
 	void SpawnTasks();
 	void JoinTasks();
@@ -43,10 +47,14 @@ private :
 	boost::asio::io_context d_context;
 	boost::asio::signal_set d_signals;
 	WorkGuard               d_guard;
-
-	std::shared_ptr<FrameGrabber>        d_grabber;
-	std::shared_ptr<ProcessFrameTask>    d_process;
-	std::shared_ptr<AcquisitionTask>     d_acquisition;
+	ThreadPlacement         d_placement;
+	ThreadBudget::Ptr       d_budget;
+	Task::RealTime          d_acquisitionRealTime,d_processRealTime;
+
+	// one of each per camera.
+	std::vector<std::shared_ptr<FrameGrabber>>     d_grabbers;
+	std::vector<std::shared_ptr<ProcessFrameTask>> d_processes;
+	std::vector<std::shared_ptr<AcquisitionTask>>  d_acquisitions;
 
 
 	std::vector<std::thread>          d_threads;
@@ -4,72 +4,265 @@
 
 #include <tbb/parallel_for.h>
 
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <numeric>
+#include <mutex>
+#include <cmath>
+
 #include <Eigen/Core>
-#include <Eigen/StdVector>
 
 namespace fort {
 namespace artemis {
 
 ApriltagDetector::ApriltagDetector(size_t maxParallel,
                                    const cv::Size & size,
-                                   const ApriltagOptions & options) {
-	d_minimumDetectionDistanceSquared = options.QuadMinClusterPixel * options.QuadMinClusterPixel;
-
-	d_detectors.reserve(maxParallel);
-	d_detectors.reserve(maxParallel);
-
-	for ( size_t i = 0 ; i < maxParallel; ++ i ) {
-		d_families.push_back(std::move(CreateFamily(options.Family)));
-		d_detectors.push_back(std::move(CreateDetector(options,d_families.back().get())));
-		Partition partition;
-		PartitionRectangle(::cv::Rect(::cv::Point(0,0),size),
-		                   i + 1,
-		                   partition);
-		AddMargin(size,75,partition);
-		d_partitions.push_back(partition);
-	}
+                                   const ApriltagOptions & options)
+	: d_options(options)
+	, d_family(SharedFamily(options.Family))
+	, d_qualities(ComputeQualities(options))
+	, d_qualityLevel(0)
+	, d_workers([this]() { return CreateWorker(); })
+	, d_margin((options.TagSize + 1) / 2)
+	, d_mask(LoadMask(options.MaskPath,size))
+	, d_merged(options.QuadMinClusterPixel,2048)
+	, d_sweepPeriod(options.TrackingSweepPeriod)
+	, d_cellSize(std::max(int(options.TrackingWindowSize),1))
+	, d_detectionCount(0) {
+	maxParallel = std::max(maxParallel,size_t(1));
+
+	// We want enough tiles for the scheduler to balance a dense nest
+	// area, but tiles not too small compared to the margin needed to
+	// see a whole tag, as overlaps are processed twice.
+	d_tileSize = std::max(6 * d_margin,
+	                      int(std::sqrt(double(size.area()) / double(4 * maxParallel))));
+	TileRectangle(cv::Rect(cv::Point(0,0),size),d_tileSize,d_tileCores);
+	CropToMask(d_mask,d_tileCores);
+	d_tiles = d_tileCores;
+	AddMargin(size,d_margin,d_tiles);
+	ComputeNeighbours(d_tiles,d_tileNeighbours);
 }
 
 void ApriltagDetector::Detect(const cv::Mat & image,
-                              size_t nThreads,
                               hermes::FrameReadout & m) {
+	bool tracking = UseTrackingWindows(image.size());
+	const auto & partition = tracking ? d_windows : d_tiles;
+	const auto & neighbours = tracking ? d_windowNeighbours : d_tileNeighbours;
+	m.set_quads(PartionnedDetection(image,partition));
+	MergeDetection(d_detections,partition,neighbours,m);
+	for ( auto & d : d_detections ) {
+		apriltag_detections_destroy(d);
+		d = nullptr;
+	}
+	UpdateTrackedTags(m);
+}
+
+std::vector<ApriltagDetector::Quality>
+ApriltagDetector::ComputeQualities(const ApriltagOptions & options) {
+	std::vector<Quality> res = {{options.QuadDecimate,options.QuadSigma,options.RefineEdges}};
+	// cheaper levels do not blur the image, and decimate it more and
+	// more. Edges are refined to recover the precision lost by
+	// decimation.
+	for ( float decimate : {1.0f,1.5f,2.0f,3.0f} ) {
+		decimate = std::max(decimate,options.QuadDecimate);
+		Quality q = {decimate,0.0f,decimate > 1.0f ? true : options.RefineEdges};
+		const auto & last = res.back();
+		if ( q.Decimate == last.Decimate
+		     && q.Sigma == last.Sigma
+		     && q.RefineEdges == last.RefineEdges ) {
+			continue;
+		}
+		res.push_back(q);
+	}
+	return res;
+}
 
-	nThreads = std::min(std::max(nThreads,size_t(1)),d_detectors.size());
+size_t ApriltagDetector::QualityLevels() const {
+	return d_qualities.size();
+}
 
-	const auto & partition = d_partitions[nThreads-1];
-	auto detections = PartionnedDetection(image,partition);
-	MergeDetection(detections,partition,m);
-	size_t nQuads = 0;
-	for ( size_t i = 0; i < nThreads; ++i ) {
-		nQuads += d_detectors[i]->nquads;
+void ApriltagDetector::SetQualityLevel(size_t level) {
+	d_qualityLevel = std::min(level,d_qualities.size()-1);
+	for ( auto & w : d_workers ) {
+		ApplyQuality(d_qualities[d_qualityLevel],w.Detector.get());
 	}
-	m.set_quads(nQuads);
-	for ( auto & d : detections ) {
-		apriltag_detections_destroy(d);
+}
+
+void ApriltagDetector::ApplyQuality(const Quality & quality,
+                                    apriltag_detector_t * detector) {
+	detector->quad_decimate = quality.Decimate;
+	detector->quad_sigma = quality.Sigma;
+	detector->refine_edges = quality.RefineEdges ? 1 : 0;
+}
+
+ApriltagDetector::Worker ApriltagDetector::CreateWorker() const {
+	// workers are only created within a detection, never while the
+	// quality level changes.
+	Worker res;
+	res.Detector = CreateDetector(d_options,d_family);
+	ApplyQuality(d_qualities[d_qualityLevel],res.Detector.get());
+	return res;
+}
+
+bool ApriltagDetector::UseTrackingWindows(const cv::Size & size) {
+	// the very first detection always sweeps the full frame, so we
+	// have some tags to track right away.
+	bool fullFrame = d_sweepPeriod == 0 || d_detectionCount == 0;
+	++d_detectionCount;
+	if ( fullFrame == true ) {
+		return false;
 	}
+	BuildTrackingWindows(size);
+	return true;
 }
 
+void ApriltagDetector::BuildTrackingWindows(const cv::Size & size) {
+	d_windows.clear();
+
+	int cols = (size.width + d_cellSize - 1) / d_cellSize;
+	int rows = (size.height + d_cellSize - 1) / d_cellSize;
+	d_activeCells.assign(cols * rows,0);
+	// a tag may have moved to any neighbouring cell since the last
+	// detection, so they are searched too.
+	for ( const auto & p : d_tracked ) {
+		int x = std::clamp(p.x / d_cellSize,0,cols-1);
+		int y = std::clamp(p.y / d_cellSize,0,rows-1);
+		for ( int ny = std::max(y-1,0); ny <= std::min(y+1,rows-1); ++ny ) {
+			for ( int nx = std::max(x-1,0); nx <= std::min(x+1,cols-1); ++nx ) {
+				d_activeCells[ny * cols + nx] = 1;
+			}
+		}
+	}
 
+	cv::Rect bounds(cv::Point(0,0),size);
+	// contiguous active cells on the same row are searched as a
+	// single window.
+	for ( int y = 0; y < rows; ++y ) {
+		for ( int x = 0; x < cols; ) {
+			if ( d_activeCells[y * cols + x] == 0 ) {
+				++x;
+				continue;
+			}
+			int start = x;
+			while( x < cols && d_activeCells[y * cols + x] != 0 ) {
+				++x;
+			}
+			d_windows.push_back(cv::Rect(start * d_cellSize,
+			                             y * d_cellSize,
+			                             (x - start) * d_cellSize,
+			                             d_cellSize) & bounds);
+		}
+	}
 
-std::vector<zarray_t*> ApriltagDetector::PartionnedDetection(const cv::Mat & image,
-                                                             const Partition & partition) {
+	// the rotating band picks up any tag entering the frame or that
+	// we lost track of.
+	int band = d_detectionCount % d_sweepPeriod;
+	int bandStart = size.height * band / d_sweepPeriod;
+	int bandEnd = size.height * (band + 1) / d_sweepPeriod;
+	// the band is cut from the tiles, which are already cropped to
+	// the mask.
+	cv::Rect bandRect(0,bandStart,size.width,bandEnd - bandStart);
+	for ( const auto & core : d_tileCores ) {
+		auto w = core & bandRect;
+		if ( w.area() > 0 ) {
+			d_windows.push_back(w);
+		}
+	}
+	AddMargin(size,d_margin,d_windows);
+	ComputeNeighbours(d_windows,d_windowNeighbours,d_windowGrid);
+}
 
-	std::vector<zarray_t*> detections(partition.size(),nullptr);
-	tbb::parallel_for(tbb::blocked_range<size_t>(0,partition.size()),
+void ApriltagDetector::UpdateTrackedTags(const hermes::FrameReadout & m) {
+	if ( d_sweepPeriod == 0 ) {
+		return;
+	}
+	d_tracked.clear();
+	for ( const auto & t : m.tags() ) {
+		d_tracked.push_back(cv::Point(t.x(),t.y()));
+	}
+}
+
+size_t ApriltagDetector::PartionnedDetection(const cv::Mat & image,
+                                             const Partition & partition) {
+	d_detections.resize(partition.size(),nullptr);
+	d_quads.resize(partition.size());
+	// the simple_partitioner with a grain of 1 lets idle threads
+	// steal single tiles from the busy ones.
+	tbb::parallel_for(tbb::blocked_range<size_t>(0,partition.size(),1),
 	                  [&] ( const tbb::blocked_range<size_t> &  range ) {
+		                  auto & worker = d_workers.local();
+		                  auto detector = worker.Detector.get();
 		                  for ( size_t i = range.begin();
 		                        i != range.end();
 		                        ++i ) {
-			                  auto cloned = cv::Mat(image,partition[i]).clone();
-			                  image_u8 img = { .width = cloned.cols,
-			                                   .height = cloned.rows,
-			                                   .stride = cloned.cols,
-			                                   .buf = cloned.data };
-			                  detections[i] = apriltag_detector_detect(d_detectors[i].get(),&img);
+			                  auto img = ImageView(image,partition[i],worker);
+			                  d_detections[i] = apriltag_detector_detect(detector,&img);
+			                  d_quads[i] = detector->nquads;
 		                  }
-	                  });
-	return detections;
+	                  },
+	                  tbb::simple_partitioner());
+	return std::accumulate(d_quads.begin(),d_quads.end(),size_t(0));
+
+}
+
+cv::Mat ApriltagDetector::LoadMask(const std::string & path,
+                                  const cv::Size & size) {
+	if ( path.empty() ) {
+		return cv::Mat();
+	}
+	auto mask = cv::imread(path,cv::IMREAD_GRAYSCALE);
+	if ( mask.empty() ) {
+		throw std::runtime_error("Could not read detection mask '" + path + "'");
+	}
+	if ( mask.size() != size ) {
+		LOG(WARNING) << "[ApriltagDetector]: resizing detection mask '" << path
+		             << "' from " << mask.size() << " to " << size;
+		cv::resize(mask,mask,size,0,0,cv::INTER_NEAREST);
+	}
+	return mask;
+}
+
+bool ApriltagDetector::IsMasked(double x, double y) const {
+	if ( d_mask.empty() ) {
+		return false;
+	}
+	int ix = std::clamp(int(x),0,d_mask.cols-1);
+	int iy = std::clamp(int(y),0,d_mask.rows-1);
+	return d_mask.at<uint8_t>(iy,ix) == 0;
+}
 
+image_u8 ApriltagDetector::ImageView(const cv::Mat & image,
+                                     const cv::Rect & roi,
+                                     Worker & worker) {
+	const auto & d = worker.Detector;
+	if ( d->quad_sigma != 0.0f && d->quad_decimate <= 1.0f ) {
+		// without decimation, apriltag blurs or sharpens its input in
+		// place. The frame buffer is shared with the other tasks, and
+		// may even be a read-only mapping, so the region is copied in
+		// the worker's scratch image, which only grows.
+		if ( worker.Scratch.cols < roi.width || worker.Scratch.rows < roi.height ) {
+			worker.Scratch.create(std::max(worker.Scratch.rows,roi.height),
+			                      std::max(worker.Scratch.cols,roi.width),
+			                      CV_8UC1);
+		}
+		auto scratch = worker.Scratch(cv::Rect(cv::Point(0,0),roi.size()));
+		image(roi).copyTo(scratch);
+		return { .width = roi.width,
+		         .height = roi.height,
+		         .stride = int32_t(scratch.step[0]),
+		         .buf = scratch.ptr<uint8_t>(0) };
+	}
+	// otherwise apriltag only reads the input image, so we can safely
+	// point into the frame buffer with its actual stride instead of
+	// copying the region.
+	return { .width = roi.width,
+	         .height = roi.height,
+	         .stride = int32_t(image.step[0]),
+	         .buf = const_cast<uint8_t*>(image.ptr<uint8_t>(roi.y) + roi.x) };
 }
 
 double ApriltagDetector::ComputeAngleFromCorner(const apriltag_detection_t *q) {
@@ -96,42 +289,61 @@ ApriltagDetector::ConvertDetection(const apriltag_detection_t * q,
 }
 
 
-void ApriltagDetector::MergeDetection(const std::vector<zarray_t*> detections,
+void ApriltagDetector::MergeDetection(const std::vector<zarray_t*> & detections,
                                       const Partition & partition,
+                                      const PartitionNeighbours & neighbours,
                                       hermes::FrameReadout & m) {
-	typedef std::vector<Eigen::Vector2d,Eigen::aligned_allocator<Eigen::Vector2d> > Vector2dList;
-
-	typedef std::map<uint32_t,Vector2dList,std::less<uint32_t>,
-	                 Eigen::aligned_allocator<std::pair<const uint32_t,Vector2dList>>> MapOfPoints;
-
-	MapOfPoints points;
+	d_merged.Clear();
+	d_overlapping.clear();
 
+	// A detection whose center is seen by a single tile cannot be a
+	// duplicate. We add them first, and only test the ones lying in
+	// an overlap zone against the already merged detections.
 	apriltag_detection_t * q;
-	size_t i = -1;
-	for ( const auto & localDetections : detections ) {
-		const auto & roi = partition[++i];
-		for ( int j = 0; j < zarray_size(localDetections); ++j) {
-			zarray_get(localDetections,j,&q);
-			const auto & [tagID,x,y,angle] = ConvertDetection(q,roi);
-			Eigen::Vector2d currentPoint(x,y);
-			auto fi = std::find_if(points[tagID].cbegin(),
-			                       points[tagID].cend(),
-			                       [this,&currentPoint]( const Eigen::Vector2d & p) {
-				                       return (currentPoint -p).squaredNorm() < d_minimumDetectionDistanceSquared;
-			                       });
-			if ( fi != points[tagID].cend() ) {
+	for ( size_t i = 0; i < detections.size(); ++i ) {
+		const auto & roi = partition[i];
+		for ( int j = 0; j < zarray_size(detections[i]); ++j) {
+			zarray_get(detections[i],j,&q);
+			double x = q->c[0] + roi.x;
+			double y = q->c[1] + roi.y;
+			if ( IsMasked(x,y) == true ) {
+				continue;
+			}
+			bool overlaps = std::any_of(neighbours[i].cbegin(),
+			                            neighbours[i].cend(),
+			                            [&partition,x,y](size_t n) {
+				                            const auto & r = partition[n];
+				                            return x >= r.x && x < r.x + r.width
+					                            && y >= r.y && y < r.y + r.height;
+			                            });
+			if ( overlaps == true ) {
+				d_overlapping.push_back({q,i});
 				continue;
 			}
-			points[tagID].push_back(currentPoint);
+			AddDetection(q,roi,m);
+		}
+	}
 
-			auto t = m.add_tags();
-			t->set_id(tagID);
-			t->set_x(x);
-			t->set_y(y);
-			t->set_theta(angle);
+	for ( const auto & [q,i] : d_overlapping ) {
+		const auto & roi = partition[i];
+		if ( d_merged.HasNeighbour(q->id,q->c[0] + roi.x,q->c[1] + roi.y) == true ) {
+			continue;
 		}
+		AddDetection(q,roi,m);
 	}
+}
 
+void ApriltagDetector::AddDetection(const apriltag_detection_t * q,
+                                    const cv::Rect & roi,
+                                    hermes::FrameReadout & m) {
+	const auto & [tagID,x,y,angle] = ConvertDetection(q,roi);
+	d_merged.Insert(tagID,x,y);
+
+	auto t = m.add_tags();
+	t->set_id(tagID);
+	t->set_x(x);
+	t->set_y(y);
+	t->set_theta(angle);
 }
 
 
@@ -162,13 +374,47 @@ ApriltagDetector::FamilyPtr ApriltagDetector::CreateFamily(tags::Family family)
 		throw std::runtime_error("Unknown fort::tags::Family(" + std::to_string(int(family)) + ")");
 	}
 
-	return FamilyPtr(fi->second.first(),fi->second.second);
+	auto destroy = fi->second.second;
+	return FamilyPtr(fi->second.first(),
+	                 [destroy](const apriltag_family_t * family) {
+		                 auto f = const_cast<apriltag_family_t*>(family);
+		                 // apriltag only releases the decoding table of
+		                 // a family when clearing the families of a
+		                 // detector.
+		                 auto d = apriltag_detector_create();
+		                 zarray_add(d->tag_families,&f);
+		                 apriltag_detector_destroy(d);
+		                 destroy(f);
+	                 });
+}
+
+ApriltagDetector::FamilyPtr ApriltagDetector::SharedFamily(tags::Family family) {
+	static std::mutex mutex;
+	static std::map<tags::Family,FamilyPtr> families;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto fi = families.find(family);
+	if ( fi != families.end() ) {
+		return fi->second;
+	}
+
+	auto res = CreateFamily(family);
+	// builds the decoding table once, while we hold the lock, using a
+	// throw-away detector.
+	auto d = apriltag_detector_create();
+	apriltag_detector_add_family(d,const_cast<apriltag_family_t*>(res.get()));
+	zarray_clear(d->tag_families);
+	apriltag_detector_destroy(d);
+
+	families[family] = res;
+	return res;
 }
 
 ApriltagDetector::DetectorPtr ApriltagDetector::CreateDetector(const ApriltagOptions & options,
-                                                               apriltag_family_t * family) {
+                                                               const FamilyPtr & family) {
 	auto d = apriltag_detector_create();
-	apriltag_detector_add_family(d,family);
+	// the decoding table is already built, it is simply re-used.
+	apriltag_detector_add_family(d,const_cast<apriltag_family_t*>(family.get()));
 	d->nthreads = 1;
 	d->quad_decimate = options.QuadDecimate;
 	d->quad_sigma = options.QuadSigma;
@@ -181,7 +427,12 @@ ApriltagDetector::DetectorPtr ApriltagDetector::CreateDetector(const ApriltagOpt
 	d->qtp.min_white_black_diff = options.QuadMinBWDiff;
 	d->qtp.deglitch = options.QuadDeglitch ? 1 : 0;
 
-	return DetectorPtr(d,apriltag_detector_destroy);
+	return DetectorPtr(d,[](apriltag_detector_t * d) {
+		                     // the family and its decoding table are
+		                     // shared and outlive the detector.
+		                     zarray_clear(d->tag_families);
+		                     apriltag_detector_destroy(d);
+	                     });
 }
 
 } // namespace artemis
@@ -3,8 +3,11 @@
 #include <apriltag/apriltag.h>
 #include <fort/hermes/FrameReadout.pb.h>
 
+#include <tbb/enumerable_thread_specific.h>
+
 #include "Options.hpp"
 #include "utils/Partitions.hpp"
+#include "SpatialHash.hpp"
 
 #include <functional>
 
@@ -20,37 +23,124 @@ public :
 	                 const ApriltagOptions & options);
 
 
+	// Detection runs in the caller's TBB arena, each of its threads
+	// getting its own apriltag detector on first use. maxParallel is
+	// the expected concurrency, used to size the tiles.
 	void Detect(const cv::Mat & mat,
-	            size_t nThreads,
 	            hermes::FrameReadout & m);
 
+	// Number of available quality levels. Level 0 uses the
+	// configured options, higher levels are cheaper to compute.
+	size_t QualityLevels() const;
+
+	void SetQualityLevel(size_t level);
+
+	typedef std::shared_ptr<const apriltag_family_t> FamilyPtr;
+
+	// Returns the process-wide instance of a family, with its
+	// decoding table built on the first call. It is immutable and
+	// shared by all detectors.
+	static FamilyPtr SharedFamily(tags::Family family);
 
 private:
-	typedef std::unique_ptr<apriltag_family_t, std::function <void (apriltag_family_t *) > > FamilyPtr;
 	typedef std::unique_ptr<apriltag_detector_t,std::function<void (apriltag_detector_t*)> > DetectorPtr;
 
 	static FamilyPtr CreateFamily(tags::Family family);
 	static DetectorPtr CreateDetector(const ApriltagOptions & options,
-	                                  apriltag_family_t * family);
+	                                  const FamilyPtr & family);
+
+	static cv::Mat LoadMask(const std::string & path,
+	                        const cv::Size & size);
+
+	bool IsMasked(double x, double y) const;
+
+	// A detector and the scratch image holding the regions apriltag
+	// would otherwise modify in place.
+	struct Worker {
+		DetectorPtr Detector;
+		cv::Mat     Scratch;
+	};
+
+	static image_u8 ImageView(const cv::Mat & image,
+	                          const cv::Rect & roi,
+	                          Worker & worker);
+
+	struct Quality {
+		float Decimate;
+		float Sigma;
+		bool  RefineEdges;
+	};
+
+	static std::vector<Quality> ComputeQualities(const ApriltagOptions & options);
+
+	Worker CreateWorker() const;
+	static void ApplyQuality(const Quality & quality,
+	                         apriltag_detector_t * detector);
 
 	static double ComputeAngleFromCorner(const apriltag_detection_t *q);
 
 	std::tuple<uint32_t,double,double,double> ConvertDetection(const apriltag_detection_t * q,
 	                                                           const cv::Rect & roi);
 
-	std::vector<zarray_t*> PartionnedDetection(const cv::Mat & image,
-	                                           const Partition & partition);
+	bool UseTrackingWindows(const cv::Size & size);
 
-	void MergeDetection(const std::vector<zarray_t*> detections,
-	                    const Partition & partition,
-	                    hermes::FrameReadout & m);
+	void BuildTrackingWindows(const cv::Size & size);
+
+	void UpdateTrackedTags(const hermes::FrameReadout & m);
 
+	size_t PartionnedDetection(const cv::Mat & image,
+	                           const Partition & partition);
 
-	std::vector<FamilyPtr>   d_families;
-	std::vector<DetectorPtr> d_detectors;
-	std::vector<Partition>   d_partitions;
+	void MergeDetection(const std::vector<zarray_t*> & detections,
+	                    const Partition & partition,
+	                    const PartitionNeighbours & neighbours,
+	                    hermes::FrameReadout & m);
 
-	double                   d_minimumDetectionDistanceSquared;
+	void AddDetection(const apriltag_detection_t * q,
+	                  const cv::Rect & roi,
+	                  hermes::FrameReadout & m);
+
+
+	const ApriltagOptions    d_options;
+	FamilyPtr                d_family;
+	std::vector<Quality>     d_qualities;
+	size_t                   d_qualityLevel;
+	// tiles are handed out to the arena threads by TBB work-stealing
+	// scheduler, and each thread uses its own worker, whatever the
+	// arena concurrency.
+	tbb::enumerable_thread_specific<Worker> d_workers;
+	// per-tile results, kept across frames to avoid reallocating
+	// them.
+	std::vector<zarray_t*>   d_detections;
+	std::vector<size_t>      d_quads;
+
+	int                      d_margin;
+	int                      d_tileSize;
+	// pixels set to zero in the mask never hold a tag. Tiles are
+	// cropped to the mask once at startup, before their margin is
+	// added.
+	cv::Mat                  d_mask;
+	Partition                d_tileCores;
+	Partition                d_tiles;
+	PartitionNeighbours      d_tileNeighbours;
+
+	// merged detections, and the ones lying in a tile overlap zone
+	// that needs to be checked for duplicates.
+	SpatialHash              d_merged;
+	std::vector<std::pair<const apriltag_detection_t*,size_t>> d_overlapping;
+
+	// tracking-guided detection: we only look in the cells that
+	// contained a tag on the previous detection and their eight
+	// neighbours, and in a band that rotates over the whole frame
+	// every d_sweepPeriod detections.
+	const size_t             d_sweepPeriod;
+	const int                d_cellSize;
+	size_t                   d_detectionCount;
+	std::vector<cv::Point>   d_tracked;
+	std::vector<uint8_t>     d_activeCells;
+	Partition                d_windows;
+	PartitionNeighbours      d_windowNeighbours;
+	NeighbourGrid            d_windowGrid;
 };
 
 
@@ -0,0 +1,76 @@
+#include "ApriltagDetectorUTest.hpp"
+
+#include "ApriltagDetector.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <tbb/task_arena.h>
+
+namespace fort {
+namespace artemis {
+
+void ApriltagDetectorUTest::RenderTag(cv::Mat & frame,
+                                      const cv::Point & position,
+                                      int scale) {
+	auto family = ApriltagDetector::SharedFamily(tags::Family::Tag36h11);
+	auto img = apriltag_to_image(const_cast<apriltag_family_t*>(family.get()),0);
+	cv::Mat tag;
+	cv::resize(cv::Mat(img->height,img->width,CV_8UC1,img->buf,img->stride),
+	           tag,cv::Size(),scale,scale,cv::INTER_NEAREST);
+	image_u8_destroy(img);
+	tag.copyTo(frame(cv::Rect(position.x - tag.cols / 2,
+	                          position.y - tag.rows / 2,
+	                          tag.cols,
+	                          tag.rows)));
+}
+
+TEST_F(ApriltagDetectorUTest,TracksTagsAcrossCells) {
+	ApriltagOptions options;
+	options.Family = tags::Family::Tag36h11;
+	options.TagSize = 50;
+	options.TrackingWindowSize = 200;
+	// the rotating band stays far away from the tag.
+	options.TrackingSweepPeriod = 100;
+
+	cv::Size size(800,600);
+	ApriltagDetector detector(2,size,options);
+	tbb::task_arena arena(2);
+
+	// the first detection sweeps the full frame, then the tag moves
+	// from the first cell well into the next one.
+	for ( const auto & position : {cv::Point(190,300),cv::Point(270,300)} ) {
+		cv::Mat frame(size,CV_8UC1,cv::Scalar(255));
+		RenderTag(frame,position,5);
+		hermes::FrameReadout m;
+		arena.execute([&]() { detector.Detect(frame,m); });
+		ASSERT_EQ(m.tags_size(),1) << "at " << position;
+		EXPECT_EQ(m.tags(0).id(),0);
+		EXPECT_NEAR(m.tags(0).x(),position.x,3.0);
+		EXPECT_NEAR(m.tags(0).y(),position.y,3.0);
+	}
+}
+
+TEST_F(ApriltagDetectorUTest,DoesNotModifyFrames) {
+	ApriltagOptions options;
+	options.Family = tags::Family::Tag36h11;
+	options.TagSize = 50;
+	// without decimation, apriltag blurs its input in place.
+	options.QuadDecimate = 1.0;
+	options.QuadSigma = 0.8;
+
+	cv::Size size(800,600);
+	ApriltagDetector detector(2,size,options);
+	tbb::task_arena arena(2);
+
+	cv::Mat frame(size,CV_8UC1,cv::Scalar(255));
+	RenderTag(frame,cv::Point(400,300),5);
+	cv::Mat expected = frame.clone();
+
+	hermes::FrameReadout m;
+	arena.execute([&]() { detector.Detect(frame,m); });
+	EXPECT_EQ(m.tags_size(),1);
+	EXPECT_EQ(cv::countNonZero(frame != expected),0);
+}
+
+} // namespace artemis
+} // namespace fort
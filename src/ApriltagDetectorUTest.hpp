@@ -0,0 +1,20 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+namespace fort {
+namespace artemis {
+
+class ApriltagDetectorUTest : public ::testing::Test {
+protected:
+	// Renders tag36h11 0 on a plain frame, with its center at
+	// position and scale pixels per tag bit.
+	static void RenderTag(cv::Mat & frame,
+	                      const cv::Point & position,
+	                      int scale);
+};
+
+} // namespace artemis
+} // namespace fort
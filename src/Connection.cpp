@@ -7,12 +7,13 @@
 
 #include <glog/logging.h>
 
-#include <google/protobuf/util/delimited_message_util.h>
 #include <fort/hermes/Header.pb.h>
 
 namespace fort {
 namespace artemis {
 
+const Duration Connection::REPLAY_RETRY_PERIOD = 10 * Duration::Millisecond;
+
 #define Connection_LOG(level,connection) LOG(level) << "[connection" \
 	<< (connection)->d_host \
 	<< ":" \
@@ -37,6 +38,8 @@ void Connection::Connect(const Ptr & self) {
 						return;
 					}
 					self->d_socket = res;
+					// sends what was queued or spooled meanwhile.
+					Flush(self);
 		                                                }));
 	} catch (const std::exception & e) {
 		Connection_LOG(ERROR,self) << "Could not connect to host: exception: " << e.what();
@@ -60,8 +63,21 @@ void Connection::Connect(const Ptr & self) {
 Connection::Ptr Connection::Create(boost::asio::io_context & context,
                                    const std::string & host,
                                    uint16_t port,
-                                   Duration reconnectPeriod ) {
-	std::shared_ptr<Connection> res(new Connection(context,host,port,reconnectPeriod));
+                                   Duration reconnectPeriod,
+                                   const LossLedger::Ptr & lossLedger,
+                                   size_t maxBatchSize,
+                                   const ReadoutSpool::Ptr & spool,
+                                   size_t replayRate) {
+	std::shared_ptr<Connection> res(new Connection(context,host,port,reconnectPeriod,lossLedger,
+	                                               maxBatchSize,spool,replayRate));
+	std::string prefix(SHARED_MEMORY_PREFIX);
+	if ( host.compare(0,prefix.size(),prefix) == 0 ) {
+		if ( host.size() == prefix.size() ) {
+			throw std::invalid_argument("Connection: shared memory ring name cannot be empty");
+		}
+		res->d_ring = std::make_shared<SharedReadoutRing>(host.substr(prefix.size()));
+		return res;
+	}
 	Connect(res);
 	return res;
 }
@@ -69,73 +85,234 @@ Connection::Ptr Connection::Create(boost::asio::io_context & context,
 Connection::Connection(boost::asio::io_context & context,
                        const std::string & host,
                        uint16_t port,
-                       Duration reconnectPeriod)
+                       Duration reconnectPeriod,
+                       const LossLedger::Ptr & lossLedger,
+                       size_t maxBatchSize,
+                       const ReadoutSpool::Ptr & spool,
+                       size_t replayRate)
 	: d_context(context)
-	, d_strand(context)
 	, d_host(host)
 	, d_port(port)
+	, d_strand(context)
 	, d_sending(false)
-	, d_reconnectPeriod(reconnectPeriod) {
+	, d_bufferPool(2 * QUEUE_CAPACITY)
+	, d_maxBatchSize(std::max(maxBatchSize,size_t(1)))
+	, d_reconnectPeriod(reconnectPeriod)
+	, d_spool(spool)
+	, d_replayRate(replayRate)
+	, d_replaying(false)
+	, d_replayTimer(context)
+	, d_lossLedger(lossLedger) {
 	if ( host.empty() ) {
 		throw std::invalid_argument("Connection: destination host cannot be empty");
 	}
-	d_bufferQueue.set_capacity(16);
+	d_bufferQueue.set_capacity(QUEUE_CAPACITY);
+	// a batch can take the whole queue and the carried message.
+	d_batch.reserve(QUEUE_CAPACITY + 1);
+	d_gather.reserve(QUEUE_CAPACITY + 1);
+	if ( d_spool ) {
+		Connection_LOG(INFO,this) << "spooling readouts to '" << d_spool->Path()
+		                          << "' while disconnected";
+	}
 
 }
 
 Connection::~Connection() {
+	if ( d_spool ) {
+		Connection_LOG(INFO,this) << d_spool->Count() << " readouts left in spool, "
+		                          << d_spool->Dropped() << " dropped as the spool was full";
+	}
 }
 
-// serializes the message to a std::string, which are allowed to
-// contain NULL character, but should be considered a glorified
-// std::vector<uint8_t> could be improved to use an allocation arena
-// instead of buffers
-inline std::string SerializeMessage(const google::protobuf::MessageLite & message ) {
-	std::ostringstream oss;
-	google::protobuf::util::SerializeDelimitedToOstream(message, &oss);
-	return oss.str();
+void Connection::Discard(const Ptr & self, uint64_t frameID, const char * reason) {
+	Connection_LOG(WARNING,self) << "discarding message as " << reason;
+	if ( self->d_lossLedger && frameID != NO_FRAME_ID ) {
+		self->d_lossLedger->Record(LossLedger::Stage::Connection,frameID,reason);
+	}
+}
+
+void Connection::PostMessage(const Ptr & self,
+                             const google::protobuf::MessageLite & message,
+                             uint64_t frameID) {
+	if ( self->d_ring ) {
+		// serialized in place, consumers are never waited for.
+		std::lock_guard<std::mutex> lock(self->d_ringMutex);
+		if ( self->d_ring->Publish(message,frameID) == false ) {
+			Discard(self,frameID,"it does not fit in the shared memory ring");
+		}
+		return;
+	}
+
+	// buffers go back to the pool once written or discarded, so
+	// sending a message does not allocate.
+	auto buffer = self->d_bufferPool.Serialize(message,frameID);
+	if ( !buffer ) {
+		Discard(self,frameID,"no buffer is available");
+	} else if ( self->d_bufferQueue.try_push(std::move(buffer)) == false ) {
+		Discard(self,frameID,"input queue is full");
+	}
+
+	self->d_strand.post([self] () { Flush(self); });
+}
 
+void Connection::Flush(const Ptr & self) {
+	if ( self->d_spool
+	     && ( !self->d_socket
+	          || self->d_replaying == true
+	          || self->d_spool->Empty() == false ) ) {
+		// messages follow the ones already spooled, to keep their order.
+		// without socket, a reconnection is already pending.
+		SpoolPending(self);
+		if ( self->d_socket && self->d_replaying == false ) {
+			ScheduleReplay(self,Duration(0));
+		}
+		return;
+	}
+
+	if(self->HasPending() == false  || self->d_sending == true) {
+		return;
+	}
+	if (!self->d_socket) {
+		MessageBuffer::Ptr discard;
+		self->PopPending(discard);
+		Discard(self,discard->FrameID(),"there is no active connection");
+		ScheduleReconnect(self);
+		return;
+	}
+	ScheduleSend(self);
+}
+
+void Connection::SpoolPending(const Ptr & self) {
+	MessageBuffer::Ptr buffer;
+	while ( self->PopPending(buffer) == true ) {
+		if ( self->d_spool->Append(buffer->FrameID(),buffer->Data(),buffer->Size()) == false ) {
+			Discard(self,buffer->FrameID(),"the spool is full");
+		}
+	}
 }
 
-void Connection::PostMessage(const Ptr & self,const google::protobuf::MessageLite & message) {
-	if ( self->d_bufferQueue.try_push(SerializeMessage(message)) == false ) {
-		Connection_LOG(WARNING,self) << "discarding message as input queue is full";
-	}
-
-	self->d_strand.post([self] () {
-		                    if(self->d_bufferQueue.size() <= 0  || self->d_sending == true) {
-			                    return;
-		                    }
-		                    if (!self->d_socket) {
-			                    Connection_LOG(WARNING,self) << "discarding message has there is no active connection";\
-			                    std::string discard;
-			                    self->d_bufferQueue.pop(discard);
-			                    ScheduleReconnect(self);
-			                    return;
-		                    }
-		                    ScheduleSend(self);
-	                    });
+void Connection::ScheduleReplay(const Ptr & self, Duration wait) {
+	self->d_replaying = true;
+	self->d_replayTimer.expires_from_now(boost::posix_time::microseconds(int64_t(wait.Microseconds())));
+	self->d_replayTimer.async_wait(self->d_strand.wrap([self](const boost::system::error_code & ec) {
+		                                                   if ( ec == boost::asio::error::operation_aborted ) {
+			                                                   return;
+		                                                   }
+		                                                   Replay(self);
+	                                                   }));
+}
+
+void Connection::Replay(const Ptr & self) {
+	if ( !self->d_socket || self->d_spool->Empty() == true ) {
+		self->d_replaying = false;
+		Flush(self);
+		return;
+	}
+	if ( self->d_sending == true ) {
+		// waits for the last live write to complete.
+		ScheduleReplay(self,REPLAY_RETRY_PERIOD);
+		return;
+	}
+
+	self->d_spool->Peek(self->d_replayed,self->d_maxBatchSize);
+	size_t bytes = 0;
+	for ( const auto & record : self->d_replayed ) {
+		self->d_gather.push_back(boost::asio::const_buffer(record.Data,record.Size));
+		bytes += record.Size;
+	}
+	self->d_sending = true;
+	// records are sent from the spool mapping, and only consumed once
+	// written.
+	boost::asio::async_write(*self->d_socket,
+	                         self->d_gather,
+	                         self->d_strand.wrap([self,bytes](const boost::system::error_code & ec,
+	                                                          std::size_t) {
+		                                             self->d_sending = false;
+		                                             self->d_gather.clear();
+		                                             if ( ec ) {
+			                                             // records stay in the spool for the next connection.
+			                                             Connection_LOG(ERROR,self) << "could not replay spooled readouts: " << ec;
+			                                             self->d_replaying = false;
+			                                             self->d_socket.reset();
+			                                             ScheduleReconnect(self);
+			                                             return;
+		                                             }
+		                                             self->d_spool->Consume(self->d_replayed.size());
+		                                             Duration wait(0);
+		                                             if ( self->d_replayRate > 0 ) {
+			                                             wait = int64_t(bytes * 1000000000ULL / self->d_replayRate);
+		                                             }
+		                                             ScheduleReplay(self,wait);
+	                                             }));
+}
+
+bool Connection::HasPending() const {
+	return d_carried || d_bufferQueue.size() > 0;
+}
+
+bool Connection::PopPending(MessageBuffer::Ptr & buffer) {
+	if ( d_carried ) {
+		buffer = std::move(d_carried);
+		d_carried.reset();
+		return true;
+	}
+	return d_bufferQueue.try_pop(buffer);
+}
+
+void Connection::FillBatch() {
+	size_t size = 0;
+	MessageBuffer::Ptr buffer;
+	while( PopPending(buffer) == true ) {
+		if ( d_batch.empty() == false && size + buffer->Size() > d_maxBatchSize ) {
+			d_carried = std::move(buffer);
+			break;
+		}
+		size += buffer->Size();
+		d_gather.push_back(boost::asio::const_buffer(buffer->Data(),buffer->Size()));
+		d_batch.push_back(std::move(buffer));
+		buffer.reset();
+	}
 }
 
 void Connection::ScheduleSend(const Ptr & self) {
 	self->d_sending = true;
-	std::string toSend;
-	self->d_bufferQueue.pop(toSend);
+	// sends everything queued so far in a single gather write. The
+	// batch keeps its buffers referenced until the write completes.
+	self->FillBatch();
 	boost::asio::async_write(*self->d_socket,
-	                         boost::asio::const_buffers_1(&((toSend)[0]),toSend.size()),
-	                         self->d_strand.wrap([self,toSend](const boost::system::error_code & ec,
-	                                                           std::size_t s) {
-		                                             if ( ec == boost::asio::error::connection_reset || ec == boost::asio::error::bad_descriptor ) {
+	                         self->d_gather,
+	                         self->d_strand.wrap([self](const boost::system::error_code & ec,
+	                                                    std::size_t s) {
+		                                             self->d_gather.clear();
+		                                             if ( ec ) {
+			                                             // any write error leaves the stream in an unknown
+			                                             // state, we start over with a new connection.
 			                                             Connection_LOG(ERROR,self) << "disconnected: " << ec;
+			                                             for ( const auto & buffer : self->d_batch ) {
+				                                             if ( self->d_spool
+				                                                  && self->d_spool->Append(buffer->FrameID(),buffer->Data(),buffer->Size()) == true ) {
+					                                             continue;
+				                                             }
+				                                             Discard(self,buffer->FrameID(),"it could not be sent");
+			                                             }
+			                                             self->d_batch.clear();
+			                                             self->d_sending = false;
+			                                             if ( self->d_spool ) {
+				                                             // messages queued meanwhile follow the failed
+				                                             // batch in the spool.
+				                                             SpoolPending(self);
+			                                             }
+			                                             // without spool, queued messages are handled by
+			                                             // PostMessage() until the socket is back.
 			                                             if (!self->d_socket) {
 				                                             return;
 			                                             }
 			                                             self->d_socket.reset();
 			                                             ScheduleReconnect(self);
-		                                             } else if ( ec ) {
-			                                             Connection_LOG(ERROR,self) << "could not send data: " << ec;
+			                                             return;
 		                                             }
-		                                             if (self->d_bufferQueue.size() <= 0 ) {
+		                                             self->d_batch.clear();
+		                                             if (self->HasPending() == false ) {
 			                                      self->d_sending = false;
 			                                      return;
 		                                             }
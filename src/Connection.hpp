@@ -1,6 +1,7 @@
 #pragma once
 
 #include <boost/asio/io_service.hpp>
+#include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/streambuf.hpp>
 #include <boost/asio/ip/tcp.hpp>
@@ -11,8 +12,14 @@
 #include <tbb/concurrent_queue.h>
 
 #include "Time.hpp"
+#include "LossLedger.hpp"
+#include "MessageBuffer.hpp"
+#include "ReadoutSpool.hpp"
+#include "SharedReadoutRing.hpp"
 
+#include <limits>
 #include <mutex>
+#include <vector>
 
 #if(BOOST_ASIO_VERSION != 101800 )
 #error "Wrong version of boost asio " # BOOST_ASIO_VERSION
@@ -25,23 +32,68 @@ class Connection {
 public:
 	typedef std::shared_ptr<Connection> Ptr;
 	~Connection();
+
+	// A host starting with SHARED_MEMORY_PREFIX, like
+	// "shm://artemis", publishes readouts in the shared memory ring
+	// named after it instead of sending them over TCP. The port, the
+	// batch size and the spool are not used.
 	static Ptr Create(boost::asio::io_context & context,
 	                  const std::string & host,
 	                  uint16_t port,
-	                  Duration reconnectPeriod = 5 * Duration::Second );
-
-	// thread-safe function
-	static void PostMessage(const Ptr & connection, const google::protobuf::MessageLite & m);
+	                  Duration reconnectPeriod = 5 * Duration::Second,
+	                  const LossLedger::Ptr & lossLedger = LossLedger::Ptr(),
+	                  size_t maxBatchSize = DEFAULT_MAX_BATCH_SIZE,
+	                  const ReadoutSpool::Ptr & spool = ReadoutSpool::Ptr(),
+	                  size_t replayRate = DEFAULT_REPLAY_RATE);
+
+	// Queued messages are sent together in a single gather write of
+	// at most maxBatchSize bytes, unless a message is larger.
+	const static size_t DEFAULT_MAX_BATCH_SIZE = 64 * 1024;
+
+	// With a spool, messages are spooled instead of discarded while
+	// there is no connection, and replayed in order once connected,
+	// at replayRate bytes per second, or as fast as possible if
+	// zero. New messages go to the spool until the replay is
+	// complete.
+	const static size_t DEFAULT_REPLAY_RATE = 1024 * 1024;
+
+	constexpr static const char * SHARED_MEMORY_PREFIX = "shm://";
+
+	// Identifies messages that are not about a frame.
+	const static uint64_t NO_FRAME_ID = MessageBuffer::NO_FRAME_ID;
+
+	// thread-safe function. Discarded messages are reported with
+	// their frameID to the loss ledger, if any.
+	static void PostMessage(const Ptr & connection,
+	                        const google::protobuf::MessageLite & m,
+	                        uint64_t frameID = NO_FRAME_ID);
 
 private :
 	Connection(boost::asio::io_context & context,
 	           const std::string & host,
 	           uint16_t port,
-	           Duration reconnectPeriod);
+	           Duration reconnectPeriod,
+	           const LossLedger::Ptr & lossLedger,
+	           size_t maxBatchSize,
+	           const ReadoutSpool::Ptr & spool,
+	           size_t replayRate);
 
 	static void ScheduleReconnect(const Ptr & self);
 	static void ScheduleSend(const Ptr & self);
 	static void Connect(const Ptr & self);
+	static void Discard(const Ptr & self, uint64_t frameID, const char * reason);
+	static void Flush(const Ptr & self);
+	static void SpoolPending(const Ptr & self);
+	static void ScheduleReplay(const Ptr & self, Duration wait);
+	static void Replay(const Ptr & self);
+
+	// Strand only functions.
+	bool HasPending() const;
+	bool PopPending(MessageBuffer::Ptr & buffer);
+	void FillBatch();
+
+	const static size_t QUEUE_CAPACITY = 16;
+	const static Duration REPLAY_RETRY_PERIOD;
 
 	boost::asio::io_context                     & d_context;
 
@@ -51,13 +103,35 @@ private :
 
 	boost::asio::io_context::strand               d_strand;
 
-	typedef tbb::concurrent_bounded_queue<std::string> BufferQueue;
+	typedef tbb::concurrent_bounded_queue<MessageBuffer::Ptr> BufferQueue;
 
 	bool      d_sending;
 
-	BufferQueue d_bufferQueue;
+	// must outlive the buffers in d_bufferQueue.
+	MessageBufferPool d_bufferPool;
+	BufferQueue       d_bufferQueue;
+
+	// Strand only. Message popped from the queue that did not fit in
+	// the last batch.
+	MessageBuffer::Ptr d_carried;
+	// Strand only. Batch being sent, reused between writes.
+	std::vector<MessageBuffer::Ptr>         d_batch;
+	std::vector<boost::asio::const_buffer>  d_gather;
+	size_t                                  d_maxBatchSize;
 
 	Duration  d_reconnectPeriod;
+
+	ReadoutSpool::Ptr                   d_spool;
+	size_t                              d_replayRate;
+	bool                                d_replaying;
+	boost::asio::deadline_timer         d_replayTimer;
+	std::vector<ReadoutSpool::Record>   d_replayed;
+
+	LossLedger::Ptr d_lossLedger;
+
+	// the ring has a single producer.
+	std::mutex                 d_ringMutex;
+	SharedReadoutRing::Ptr     d_ring;
 };
 
 } // namespace artemis
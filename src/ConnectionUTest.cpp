@@ -11,9 +11,12 @@
 #include <fort/hermes/Header.pb.h>
 
 #include "Connection.hpp"
+#include "Options.hpp"
 
 #include <glog/logging.h>
 
+#include <unistd.h>
+
 namespace fort {
 namespace artemis {
 
@@ -137,6 +140,115 @@ TEST_F(ConnectionUTest,DoesNotMangle) {
 
 }
 
+TEST_F(ConnectionUTest,SendsMessagesLargerThanABatch) {
+	d_running.Wait();
+	auto connection = Connection::Create(d_context,
+	                                     "localhost",
+	                                     12345,
+	                                     5 * Duration::Second,
+	                                     LossLedger::Ptr(),
+	                                     1);
+	d_accept.Wait();
+	for (size_t i = 0; i < 4; ++i) {
+		fort::hermes::FrameReadout m;
+		m.set_frameid(i+1);
+		m.set_timestamp(20000*(i+1));
+		Connection::PostMessage(connection,m);
+	}
+
+	connection.reset();
+	d_closed.Wait();
+}
+
+TEST_F(ConnectionUTest,ReplaysSpooledMessages) {
+	d_running.Wait();
+	auto path = ::testing::TempDir() + "/artemis-spool-" + std::to_string(getpid());
+	auto spool = std::make_shared<ReadoutSpool>(path,64 * 1024);
+	// nobody listens yet, messages are spooled.
+	auto connection = Connection::Create(d_context,
+	                                     "localhost",
+	                                     12347,
+	                                     std::chrono::milliseconds(5),
+	                                     LossLedger::Ptr(),
+	                                     // replays one message at a time.
+	                                     1,
+	                                     spool,
+	                                     0);
+	for (size_t i = 0; i < 4; ++i) {
+		fort::hermes::FrameReadout m;
+		m.set_frameid(i+1);
+		m.set_timestamp(20000*(i+1));
+		Connection::PostMessage(connection,m);
+	}
+
+	boost::asio::ip::tcp::acceptor late(d_context,boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(),12347));
+	auto incoming = std::make_shared<IncommingConnection>(d_context,d_closed);
+	late.async_accept(incoming->d_socket,[this,incoming](const boost::system::error_code & ec) {
+		                                     EXPECT_EQ(!ec,true);
+		                                     IncommingConnection::Read(incoming);
+		                                     d_accept.SignalOne();
+	                                     });
+	d_accept.Wait();
+
+	connection.reset();
+	d_closed.Wait();
+	EXPECT_EQ(incoming->d_received,4);
+	unlink(path.c_str());
+}
+
+TEST_F(ConnectionUTest,PublishesInSharedMemory) {
+	auto name = "artemis-connection-" + std::to_string(getpid());
+	auto connection = Connection::Create(d_context,Connection::SHARED_MEMORY_PREFIX + name,0);
+	SharedReadoutRing::Reader reader(name);
+
+	fort::hermes::FrameReadout m;
+	m.set_frameid(1);
+	m.set_timestamp(20000);
+	Connection::PostMessage(connection,m,1);
+
+	fort::hermes::FrameReadout received;
+	uint64_t frameID = 0;
+	ASSERT_EQ(reader.Next(received,frameID,Duration::Second),
+	          SharedReadoutRing::Reader::Status::OK);
+	EXPECT_EQ(frameID,1);
+	EXPECT_EQ(received.timestamp(),20000);
+}
+
+TEST_F(ConnectionUTest,PublishesEachCameraInSharedMemory) {
+	Options options;
+	options.Camera.Count = 2;
+	options.Network.Host = Connection::SHARED_MEMORY_PREFIX + ("artemis-cameras-" + std::to_string(getpid()));
+	std::string prefix(Connection::SHARED_MEMORY_PREFIX);
+	EXPECT_THROW(Connection::Create(d_context,prefix,0),std::invalid_argument);
+
+	std::vector<Connection::Ptr> connections;
+	std::vector<std::unique_ptr<SharedReadoutRing::Reader>> readers;
+	for ( size_t i = 0; i < options.Camera.Count; ++i ) {
+		auto host = options.ForCamera(i).Network.Host;
+		connections.push_back(Connection::Create(d_context,host,0));
+		readers.push_back(std::make_unique<SharedReadoutRing::Reader>(host.substr(prefix.size())));
+	}
+
+	for ( size_t i = 0; i < connections.size(); ++i ) {
+		fort::hermes::FrameReadout m;
+		m.set_frameid(10 * (i+1));
+		m.set_timestamp(20000 * (i+1));
+		Connection::PostMessage(connections[i],m,10 * (i+1));
+	}
+
+	// each camera only reads its own readouts.
+	for ( size_t i = 0; i < readers.size(); ++i ) {
+		fort::hermes::FrameReadout received;
+		uint64_t frameID = 0;
+		ASSERT_EQ(readers[i]->Next(received,frameID,Duration::Second),
+		          SharedReadoutRing::Reader::Status::OK) << "camera " << i;
+		EXPECT_EQ(frameID,10 * (i+1));
+		EXPECT_EQ(received.timestamp(),20000 * (i+1));
+		EXPECT_EQ(readers[i]->Next(received,frameID,Duration::Millisecond),
+		          SharedReadoutRing::Reader::Status::TIMEOUT) << "camera " << i;
+	}
+}
+
 TEST_F(ConnectionUTest,CanReconnect) {
 	d_running.Wait();
 	auto connection = Connection::Create(d_context,"localhost",12346,std::chrono::milliseconds(5));
@@ -2,18 +2,30 @@
 
 #include <glog/logging.h>
 #include <regex>
+#include <algorithm>
 
 namespace fort {
 namespace artemis {
 
+const Duration EuresysFrameGrabber::STATISTICS_PERIOD = Duration::Minute;
 
 EuresysFrameGrabber::EuresysFrameGrabber(Euresys::EGenTL & gentl,
                                          const CameraOptions & options)
-	: Euresys::EGrabber<Euresys::CallbackOnDemand>(gentl)
+	// cameras are the devices of the first interface, one per
+	// connection.
+	: Euresys::EGrabber<Euresys::CallbackOnDemand>(gentl,0,options.Index)
 	, d_lastFrame(0)
 	, d_toAdd(0)
 	, d_width(0)
-	, d_height(0) {
+	, d_height(0)
+	, d_buffers(std::max(options.Buffers,size_t(2)))
+	, d_held(std::make_shared<std::atomic<size_t>>(0))
+	, d_lastID(0)
+	, d_hasLastID(false) {
+	d_maxOccupancy.store(0);
+	d_overruns.store(0);
+	d_gaps.store(0);
+	d_lost.store(0);
 
 	using namespace Euresys;
 
@@ -64,12 +76,13 @@ EuresysFrameGrabber::EuresysFrameGrabber(Euresys::EGenTL & gentl,
 
 	DLOG(INFO) << "Enable Event";
 	enableEvent<NewBufferData>();
-	DLOG(INFO) << "Realloc Buffer";
-	reallocBuffers(4);
+	DLOG(INFO) << "Realloc Buffer: " << d_buffers;
+	reallocBuffers(d_buffers);
 }
 
 void EuresysFrameGrabber::Start() {
 	DLOG(INFO) << "Starting framegrabber";
+	d_nextStatistics = Time::Now().Add(STATISTICS_PERIOD);
 	start();
 }
 
@@ -77,6 +90,17 @@ void EuresysFrameGrabber::Stop() {
 	DLOG(INFO) << "Stopping framegrabber";
 	stop();
 	DLOG(INFO) << "Framegrabber stopped";
+	LogStatistics();
+}
+
+void EuresysFrameGrabber::LogStatistics() {
+	auto stats = Statistics();
+	LOG(INFO) << "[EuresysFrameGrabber]: buffers: " << stats.Buffers
+	          << ", occupancy: " << stats.Occupancy
+	          << ", max occupancy: " << stats.MaxOccupancy
+	          << ", overruns: " << stats.Overruns
+	          << ", frame ID gaps: " << stats.FrameIDGaps
+	          << ", frames lost: " << stats.FramesLost;
 }
 
 
@@ -97,16 +121,64 @@ Frame::Ptr EuresysFrameGrabber::NextFrame() {
 
 void EuresysFrameGrabber::onNewBufferEvent(const Euresys::NewBufferData &data) {
 	std::unique_lock<std::mutex> lock(d_mutex);
-	d_frame = std::make_shared<EuresysFrame>(*this,data,d_lastFrame,d_toAdd);
+	d_frame = std::make_shared<EuresysFrame>(*this,data,d_lastFrame,d_toAdd,d_held);
+	UpdateStatistics(*d_frame);
 }
 
-EuresysFrame::EuresysFrame(Euresys::EGrabber<Euresys::CallbackOnDemand> & grabber, const Euresys::NewBufferData & data, uint64_t & lastFrame, uint64_t & toAdd )
+void EuresysFrameGrabber::UpdateStatistics(const Frame & frame) {
+	// the new frame is already counted.
+	size_t occupancy = d_held->load();
+	if ( occupancy > d_maxOccupancy.load() ) {
+		d_maxOccupancy.store(occupancy);
+	}
+	if ( occupancy >= d_buffers ) {
+		// until one frame is released, the camera has nowhere to write.
+		auto overruns = d_overruns.fetch_add(1) + 1;
+		LOG_EVERY_N(WARNING,100) << "[EuresysFrameGrabber]: all " << d_buffers
+		                         << " buffers are held by processing, overruns: " << overruns;
+	}
+
+	if ( d_hasLastID == true && frame.ID() > d_lastID + 1 ) {
+		size_t missing = frame.ID() - d_lastID - 1;
+		// each gap is reported by the acquisition task.
+		d_gaps.fetch_add(1);
+		d_lost.fetch_add(missing);
+	}
+	d_lastID = frame.ID();
+	d_hasLastID = true;
+
+	// a buffer shortage builds up slowly, it must be visible before
+	// the acquisition stops.
+	if ( frame.Time().Before(d_nextStatistics) == true ) {
+		return;
+	}
+	d_nextStatistics = frame.Time().Add(STATISTICS_PERIOD);
+	LogStatistics();
+}
+
+EuresysFrameGrabber::BufferStatistics EuresysFrameGrabber::Statistics() const {
+	return BufferStatistics{.Buffers = d_buffers,
+	                        .Occupancy = d_held->load(),
+	                        .MaxOccupancy = d_maxOccupancy.load(),
+	                        .Overruns = d_overruns.load(),
+	                        .FrameIDGaps = d_gaps.load(),
+	                        .FramesLost = d_lost.load(),
+	};
+}
+
+EuresysFrame::EuresysFrame(Euresys::EGrabber<Euresys::CallbackOnDemand> & grabber,
+                           const Euresys::NewBufferData & data,
+                           uint64_t & lastFrame,
+                           uint64_t & toAdd,
+                           const std::shared_ptr<std::atomic<size_t>> & held)
 	: Euresys::ScopedBuffer(grabber,data)
 	, d_width(getInfo<size_t>(GenTL::BUFFER_INFO_WIDTH))
 	, d_height(getInfo<size_t>(GenTL::BUFFER_INFO_HEIGHT))
 	, d_timestamp(getInfo<uint64_t>(GenTL::BUFFER_INFO_TIMESTAMP))
 	, d_ID(getInfo<uint64_t>(GenTL::BUFFER_INFO_FRAMEID))
-	, d_mat(d_height,d_width,CV_8U,getInfo<void*>(GenTL::BUFFER_INFO_BASE)) {
+	, d_mat(d_height,d_width,CV_8U,getInfo<void*>(GenTL::BUFFER_INFO_BASE))
+	, d_held(held) {
+	d_held->fetch_add(1);
 	if ( d_ID == 0 && lastFrame != 0 ) {
 		toAdd += lastFrame + 1;
 	}
@@ -114,7 +186,10 @@ EuresysFrame::EuresysFrame(Euresys::EGrabber<Euresys::CallbackOnDemand> & grabbe
 	d_ID += toAdd;
 }
 
-EuresysFrame::~EuresysFrame() {}
+EuresysFrame::~EuresysFrame() {
+	// the buffer is given back to the grabber right after.
+	d_held->fetch_sub(1);
+}
 
 size_t EuresysFrame::Width() const {
 	return d_width;
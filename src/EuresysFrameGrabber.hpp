@@ -7,6 +7,7 @@
 #include "Options.hpp"
 
 #include <opencv2/core/core.hpp>
+#include <atomic>
 #include <mutex>
 
 
@@ -18,7 +19,8 @@ public :
 	EuresysFrame(Euresys::EGrabber<Euresys::CallbackOnDemand> & grabber,
 				 const Euresys::NewBufferData &,
 				 uint64_t & lastFrame,
-				 uint64_t & toAdd);
+				 uint64_t & toAdd,
+				 const std::shared_ptr<std::atomic<size_t>> & held);
 
 	virtual ~EuresysFrame();
 
@@ -33,6 +35,8 @@ private :
 	size_t d_width,d_height;
 	uint64_t d_timestamp,d_ID;
 	cv::Mat d_mat;
+	// shared with the grabber, as frames may outlive it.
+	std::shared_ptr<std::atomic<size_t>> d_held;
 	friend class EuresysFrameGrabbero;
 };
 
@@ -52,7 +56,29 @@ public :
 	Frame::Ptr NextFrame() override;
 
 	cv::Size Resolution() const override;
+
+	struct BufferStatistics {
+		// Number of announced buffers.
+		size_t Buffers;
+		// Buffers currently held by frames in the processing chain.
+		size_t Occupancy;
+		size_t MaxOccupancy;
+		// Times all buffers were held, leaving none to the camera.
+		size_t Overruns;
+		// Discontinuities in BUFFER_INFO_FRAMEID, and the frames they
+		// account for.
+		size_t FrameIDGaps;
+		size_t FramesLost;
+	};
+
+	BufferStatistics Statistics() const;
+
+	// Statistics are logged at this period while acquiring.
+	const static Duration STATISTICS_PERIOD;
+
 private:
+	void UpdateStatistics(const Frame & frame);
+	void LogStatistics();
 
 	virtual void onNewBufferEvent(const Euresys::NewBufferData &data);
 
@@ -61,6 +87,13 @@ private:
 	uint64_t           d_lastFrame;
 	uint64_t           d_toAdd;
 	int32_t            d_width,d_height;
+
+	size_t                               d_buffers;
+	std::shared_ptr<std::atomic<size_t>> d_held;
+	std::atomic<size_t>                  d_maxOccupancy,d_overruns,d_gaps,d_lost;
+	uint64_t                             d_lastID;
+	bool                                 d_hasLastID;
+	Time                                 d_nextStatistics;
 };
 
 
@@ -12,11 +12,19 @@ Frame::~Frame() {}
 
 FrameGrabber::~FrameGrabber() {}
 
+bool FrameGrabber::ContiguousFrameIDs() const {
+	return true;
+}
+
 
 const fort::artemis::Time & Frame::Time() const {
 	return d_time;
 }
 
+void Frame::SetTime(const fort::artemis::Time & time) {
+	d_time = time;
+}
+
 
 } // namespace artemis
 } // namespace fort
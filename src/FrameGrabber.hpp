@@ -25,6 +25,9 @@ public:
 	virtual uint64_t ID() const = 0;
 	virtual const cv::Mat & ToCV() = 0;
 	const fort::artemis::Time & Time() const;
+protected:
+	// for frame objects that are recycled.
+	void SetTime(const fort::artemis::Time & time);
 private:
 
 	fort::artemis::Time d_time;
@@ -42,6 +45,10 @@ public :
 	virtual Frame::Ptr NextFrame() = 0;
 
 	virtual cv::Size Resolution() const = 0;
+
+	// Tells if frame IDs follow each other, so any gap between two
+	// frames is a lost frame. Recordings may skip IDs.
+	virtual bool ContiguousFrameIDs() const;
 };
 
 } // namespace artemis
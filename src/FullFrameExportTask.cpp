@@ -7,8 +7,10 @@
 namespace fort {
 namespace artemis {
 
-FullFrameExportTask::FullFrameExportTask(const std::string & dir)
-	: d_dir(dir) {
+FullFrameExportTask::FullFrameExportTask(const std::string & dir,
+                                         const ThreadBudget::Ptr & budget)
+	: d_dir(dir)
+	, d_budget(budget) {
 	if ( dir.empty() ) {
 		throw std::invalid_argument("No directory for output");
 	}
@@ -24,7 +26,8 @@ void FullFrameExportTask::Run() {
 		if (!f) {
 			break;
 		}
-		ExportFrame(d_dir,f);
+		// any parallel encoding stays within the export budget.
+		d_budget->Export().execute([&]() { ExportFrame(d_dir,f); });
 	}
 	LOG(INFO) << "[FullFrameExportTask]: ended";
 }
@@ -3,6 +3,7 @@
 #include "Task.hpp"
 
 #include "FrameGrabber.hpp"
+#include "ThreadBudget.hpp"
 
 #include <tbb/concurrent_queue.h>
 
@@ -12,7 +13,8 @@ namespace artemis {
 
 class FullFrameExportTask : public Task {
 public:
-	FullFrameExportTask(const std::string & dir);
+	FullFrameExportTask(const std::string & dir,
+	                    const ThreadBudget::Ptr & budget);
 	virtual ~FullFrameExportTask();
 
 	void Run();
@@ -29,6 +31,7 @@ private:
 
 	tbb::concurrent_bounded_queue<Frame::Ptr> d_queue;
 	std::string d_dir;
+	ThreadBudget::Ptr d_budget;
 };
 
 } // namespace artemis
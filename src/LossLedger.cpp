@@ -0,0 +1,121 @@
+#include "LossLedger.hpp"
+
+#include <google/protobuf/unknown_field_set.h>
+
+#include <sstream>
+
+namespace fort {
+namespace artemis {
+
+const int LossLedger::READOUT_TOTAL_FIELD;
+const int LossLedger::READOUT_STAGE_FIELD;
+
+LossLedger::LossLedger(size_t history)
+	: d_history(std::max(history,size_t(1)))
+	, d_next(0)
+	, d_size(0) {
+	for ( auto & lost : d_lost ) {
+		lost.store(0);
+	}
+}
+
+void LossLedger::Record(Stage where, uint64_t frameID, const char * reason) {
+	RecordGap(where,frameID,1,reason);
+}
+
+void LossLedger::RecordGap(Stage where, uint64_t firstID, size_t count, const char * reason) {
+	if ( count == 0 ) {
+		return;
+	}
+	d_lost[size_t(where)].fetch_add(count);
+	// a gap larger than the history would only overwrite itself.
+	size_t toAppend = std::min(count,d_history.size());
+	std::lock_guard<std::mutex> lock(d_mutex);
+	for ( uint64_t ID = firstID + count - toAppend; ID < firstID + count; ++ID ) {
+		Append({.FrameID = ID, .Where = where, .Reason = reason});
+	}
+}
+
+void LossLedger::Append(const Entry & entry) {
+	d_history[d_next] = entry;
+	d_next = (d_next + 1) % d_history.size();
+	d_size = std::min(d_size + 1,d_history.size());
+}
+
+size_t LossLedger::Lost(Stage where) const {
+	return d_lost[size_t(where)].load();
+}
+
+size_t LossLedger::TotalLost() const {
+	size_t res = 0;
+	for ( const auto & lost : d_lost ) {
+		res += lost.load();
+	}
+	return res;
+}
+
+bool LossLedger::Find(uint64_t frameID, Entry & entry) const {
+	std::lock_guard<std::mutex> lock(d_mutex);
+	for ( size_t i = 1; i <= d_size; ++i ) {
+		const auto & e = d_history[(d_next + d_history.size() - i) % d_history.size()];
+		if ( e.FrameID == frameID ) {
+			entry = e;
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<LossLedger::Entry> LossLedger::Recent() const {
+	std::lock_guard<std::mutex> lock(d_mutex);
+	std::vector<Entry> res;
+	res.reserve(d_size);
+	for ( size_t i = d_size; i > 0; --i ) {
+		res.push_back(d_history[(d_next + d_history.size() - i) % d_history.size()]);
+	}
+	return res;
+}
+
+void LossLedger::TagReadout(hermes::FrameReadout & readout) const {
+	auto fields = readout.GetReflection()->MutableUnknownFields(&readout);
+	size_t lost[NB_STAGES];
+	size_t total = 0;
+	for ( size_t i = 0; i < NB_STAGES; ++i ) {
+		lost[i] = d_lost[i].load();
+		total += lost[i];
+	}
+	fields->AddVarint(READOUT_TOTAL_FIELD,total);
+	for ( size_t i = 0; i < NB_STAGES; ++i ) {
+		fields->AddVarint(READOUT_STAGE_FIELD + i,lost[i]);
+	}
+}
+
+std::string LossLedger::Summary() const {
+	std::ostringstream oss;
+	std::string prefix;
+	for ( size_t i = 0; i < NB_STAGES; ++i ) {
+		oss << prefix << StageName(Stage(i)) << ": " << d_lost[i].load();
+		prefix = ", ";
+	}
+	return oss.str();
+}
+
+const char * LossLedger::StageName(Stage where) {
+	switch(where) {
+	case Stage::Acquisition:
+		return "acquisition";
+	case Stage::Processing:
+		return "processing";
+	case Stage::VideoOutput:
+		return "video output";
+	case Stage::Connection:
+		return "connection";
+	case Stage::Recorder:
+		return "recorder";
+	default:
+		return "unknown";
+	}
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <fort/hermes/FrameReadout.pb.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fort {
+namespace artemis {
+
+// Accounts for the frames lost along the pipeline, from acquisition
+// to the network. Every stage reports the frames it drops, and the
+// ledger keeps per-stage counters and the most recent losses with
+// their reason. All methods are thread-safe.
+class LossLedger {
+public:
+	typedef std::shared_ptr<LossLedger> Ptr;
+
+	// values number the readout fields below, new stages are only
+	// appended.
+	enum class Stage {
+		Acquisition = 0,
+		Processing,
+		VideoOutput,
+		Connection,
+		Recorder,
+		NB_STAGES,
+	};
+
+	struct Entry {
+		uint64_t     FrameID;
+		Stage        Where;
+		// static string, describing why the frame was lost.
+		const char * Reason;
+	};
+
+	// Cumulative losses are added to readouts as unknown varint
+	// fields, as the readout schema cannot be extended from here. The
+	// field numbers are a stable contract with readout consumers:
+	//   1000: total
+	//   1001: acquisition
+	//   1002: processing
+	//   1003: video output
+	//   1004: connection
+	//   1005: recorder
+	// READOUT_STAGE_FIELD + stage holds the losses of a stage.
+	const static int READOUT_TOTAL_FIELD = 1000;
+	const static int READOUT_STAGE_FIELD = 1001;
+
+	const static size_t DEFAULT_HISTORY = 1024;
+
+	LossLedger(size_t history = DEFAULT_HISTORY);
+
+	void Record(Stage where, uint64_t frameID, const char * reason);
+
+	// Records count consecutive frames starting at firstID.
+	void RecordGap(Stage where, uint64_t firstID, size_t count, const char * reason);
+
+	size_t Lost(Stage where) const;
+	size_t TotalLost() const;
+
+	// Finds the most recent loss of a frame, if it is still in the
+	// history.
+	bool Find(uint64_t frameID, Entry & entry) const;
+
+	// Most recent losses, oldest first.
+	std::vector<Entry> Recent() const;
+
+	void TagReadout(hermes::FrameReadout & readout) const;
+
+	std::string Summary() const;
+
+	static const char * StageName(Stage where);
+
+private:
+	void Append(const Entry & entry);
+
+	const static size_t NB_STAGES = size_t(Stage::NB_STAGES);
+
+	std::atomic<size_t> d_lost[NB_STAGES];
+
+	mutable std::mutex  d_mutex;
+	std::vector<Entry>  d_history;
+	size_t              d_next;
+	size_t              d_size;
+};
+
+} // namespace artemis
+} // namespace fort
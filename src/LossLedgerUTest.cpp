@@ -0,0 +1,76 @@
+#include "LossLedgerUTest.hpp"
+
+#include "LossLedger.hpp"
+
+#include <google/protobuf/unknown_field_set.h>
+
+namespace fort {
+namespace artemis {
+
+TEST_F(LossLedgerUTest,CountsPerStage) {
+	LossLedger ledger;
+	ledger.Record(LossLedger::Stage::Processing,12,"queue full");
+	ledger.RecordGap(LossLedger::Stage::Acquisition,20,3,"frame ID gap");
+	ledger.Record(LossLedger::Stage::Connection,25,"no connection");
+
+	EXPECT_EQ(ledger.Lost(LossLedger::Stage::Acquisition),3);
+	EXPECT_EQ(ledger.Lost(LossLedger::Stage::Processing),1);
+	EXPECT_EQ(ledger.Lost(LossLedger::Stage::VideoOutput),0);
+	EXPECT_EQ(ledger.Lost(LossLedger::Stage::Connection),1);
+	EXPECT_EQ(ledger.TotalLost(),5);
+
+	LossLedger::Entry entry;
+	ASSERT_TRUE(ledger.Find(21,entry));
+	EXPECT_EQ(entry.FrameID,21);
+	EXPECT_EQ(entry.Where,LossLedger::Stage::Acquisition);
+	EXPECT_STREQ(entry.Reason,"frame ID gap");
+	EXPECT_FALSE(ledger.Find(13,entry));
+}
+
+TEST_F(LossLedgerUTest,KeepsMostRecentLosses) {
+	LossLedger ledger(4);
+	for ( uint64_t ID = 0; ID < 6; ++ID ) {
+		ledger.Record(LossLedger::Stage::VideoOutput,ID,"late");
+	}
+	auto recent = ledger.Recent();
+	ASSERT_EQ(recent.size(),4);
+	for ( size_t i = 0; i < recent.size(); ++i ) {
+		EXPECT_EQ(recent[i].FrameID,i+2);
+	}
+
+	// counters are not limited by the history.
+	ledger.RecordGap(LossLedger::Stage::Acquisition,100,10,"gap");
+	EXPECT_EQ(ledger.Lost(LossLedger::Stage::Acquisition),10);
+	recent = ledger.Recent();
+	ASSERT_EQ(recent.size(),4);
+	EXPECT_EQ(recent.front().FrameID,106);
+	EXPECT_EQ(recent.back().FrameID,109);
+}
+
+TEST_F(LossLedgerUTest,TagsReadouts) {
+	LossLedger ledger;
+	ledger.Record(LossLedger::Stage::Processing,1,"queue full");
+	ledger.RecordGap(LossLedger::Stage::Acquisition,3,2,"frame ID gap");
+
+	hermes::FrameReadout m;
+	m.set_frameid(5);
+	ledger.TagReadout(m);
+
+	hermes::FrameReadout parsed;
+	ASSERT_TRUE(parsed.ParseFromString(m.SerializeAsString()));
+	EXPECT_EQ(parsed.frameid(),5);
+	const auto & fields = parsed.GetReflection()->GetUnknownFields(parsed);
+	ASSERT_EQ(fields.field_count(),6);
+	// the numbers are a contract with the readout consumers.
+	EXPECT_EQ(fields.field(0).number(),1000);
+	EXPECT_EQ(fields.field(0).varint(),3);
+	EXPECT_EQ(fields.field(1).number(),1001);
+	EXPECT_EQ(fields.field(1).varint(),2);
+	EXPECT_EQ(fields.field(2).number(),1002);
+	EXPECT_EQ(fields.field(2).varint(),1);
+	EXPECT_EQ(fields.field(5).number(),1005);
+	EXPECT_EQ(fields.field(5).varint(),0);
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,94 @@
+#include "MessageBuffer.hpp"
+
+#include <google/protobuf/io/coded_stream.h>
+
+namespace fort {
+namespace artemis {
+
+const uint64_t MessageBuffer::NO_FRAME_ID;
+
+MessageBuffer::MessageBuffer(MessageBufferPool & pool, size_t capacity)
+	: d_pool(pool)
+	, d_data(capacity)
+	, d_size(0)
+	, d_frameID(NO_FRAME_ID) {
+	d_references.store(0);
+}
+
+const uint8_t * MessageBuffer::Data() const {
+	return d_data.data();
+}
+
+size_t MessageBuffer::Size() const {
+	return d_size;
+}
+
+uint64_t MessageBuffer::FrameID() const {
+	return d_frameID;
+}
+
+size_t MessageBuffer::Capacity() const {
+	return d_data.size();
+}
+
+void MessageBuffer::Serialize(const google::protobuf::MessageLite & message, uint64_t frameID) {
+	using namespace google::protobuf::io;
+	// caches the sizes of sub-messages for SerializeWithCachedSizesToArray().
+	size_t messageSize = message.ByteSizeLong();
+	size_t size = CodedOutputStream::VarintSize32(messageSize) + messageSize;
+	if ( size > d_data.size() ) {
+		d_data.resize(size);
+	}
+	auto data = CodedOutputStream::WriteVarint32ToArray(messageSize,d_data.data());
+	message.SerializeWithCachedSizesToArray(data);
+	d_size = size;
+	d_frameID = frameID;
+}
+
+void intrusive_ptr_add_ref(MessageBuffer * buffer) {
+	buffer->d_references.fetch_add(1,std::memory_order_relaxed);
+}
+
+void intrusive_ptr_release(MessageBuffer * buffer) {
+	if ( buffer->d_references.fetch_sub(1,std::memory_order_acq_rel) == 1 ) {
+		buffer->d_pool.Release(buffer);
+	}
+}
+
+
+MessageBufferPool::MessageBufferPool(size_t count, size_t capacity) {
+	for ( size_t i = 0; i < count; ++i ) {
+		d_buffers.push_back(std::unique_ptr<MessageBuffer>(new MessageBuffer(*this,capacity)));
+		d_free.push(d_buffers.back().get());
+	}
+}
+
+MessageBufferPool::~MessageBufferPool() {
+}
+
+MessageBuffer::Ptr MessageBufferPool::Serialize(const google::protobuf::MessageLite & message,
+                                                uint64_t frameID) {
+	MessageBuffer * buffer;
+	if ( d_free.try_pop(buffer) == false ) {
+		return MessageBuffer::Ptr();
+	}
+	MessageBuffer::Ptr res(buffer);
+	res->Serialize(message,frameID);
+	return res;
+}
+
+size_t MessageBufferPool::Count() const {
+	return d_buffers.size();
+}
+
+size_t MessageBufferPool::Available() const {
+	auto size = d_free.size();
+	return size > 0 ? size_t(size) : 0;
+}
+
+void MessageBufferPool::Release(MessageBuffer * buffer) {
+	d_free.push(buffer);
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <google/protobuf/message_lite.h>
+
+#include <boost/intrusive_ptr.hpp>
+
+#include <tbb/concurrent_queue.h>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace fort {
+namespace artemis {
+
+class MessageBufferPool;
+
+// A length-delimited serialized message, as expected by hermes
+// consumers: the varint size of the message followed by its
+// bytes. Buffers belong to a MessageBufferPool and are reference
+// counted, they go back to their pool once the last reference is
+// released, keeping their storage for the next message.
+class MessageBuffer {
+public:
+	typedef boost::intrusive_ptr<MessageBuffer> Ptr;
+
+	// Identifies messages that are not about a frame.
+	const static uint64_t NO_FRAME_ID = std::numeric_limits<uint64_t>::max();
+
+	const uint8_t * Data() const;
+	size_t Size() const;
+	uint64_t FrameID() const;
+
+	// Storage currently reserved by the buffer.
+	size_t Capacity() const;
+
+private:
+	friend class MessageBufferPool;
+	friend void intrusive_ptr_add_ref(MessageBuffer * buffer);
+	friend void intrusive_ptr_release(MessageBuffer * buffer);
+
+	MessageBuffer(MessageBufferPool & pool, size_t capacity);
+
+	void Serialize(const google::protobuf::MessageLite & message, uint64_t frameID);
+
+	MessageBufferPool  & d_pool;
+	std::vector<uint8_t> d_data;
+	size_t               d_size;
+	uint64_t             d_frameID;
+	std::atomic<size_t>  d_references;
+};
+
+void intrusive_ptr_add_ref(MessageBuffer * buffer);
+void intrusive_ptr_release(MessageBuffer * buffer);
+
+// Fixed set of MessageBuffer allocated once. Serialize() does not
+// allocate unless a message is larger than any previous one in the
+// buffer it uses. The pool must outlive all of its buffers. Thread-safe.
+class MessageBufferPool {
+public:
+	typedef std::shared_ptr<MessageBufferPool> Ptr;
+
+	const static size_t DEFAULT_CAPACITY = 4096;
+
+	MessageBufferPool(size_t count, size_t capacity = DEFAULT_CAPACITY);
+	~MessageBufferPool();
+
+	// Serializes message in a free buffer. Returns an empty pointer
+	// if all buffers are in use.
+	MessageBuffer::Ptr Serialize(const google::protobuf::MessageLite & message,
+	                             uint64_t frameID = MessageBuffer::NO_FRAME_ID);
+
+	size_t Count() const;
+	size_t Available() const;
+
+private:
+	friend void intrusive_ptr_release(MessageBuffer * buffer);
+
+	void Release(MessageBuffer * buffer);
+
+	std::vector<std::unique_ptr<MessageBuffer>> d_buffers;
+	tbb::concurrent_bounded_queue<MessageBuffer*> d_free;
+};
+
+} // namespace artemis
+} // namespace fort
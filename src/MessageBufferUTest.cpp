@@ -0,0 +1,57 @@
+#include "MessageBufferUTest.hpp"
+
+#include "MessageBuffer.hpp"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/util/delimited_message_util.h>
+#include <fort/hermes/FrameReadout.pb.h>
+
+namespace fort {
+namespace artemis {
+
+TEST_F(MessageBufferUTest,SerializesDelimitedMessages) {
+	MessageBufferPool pool(1,4);
+	hermes::FrameReadout m;
+	m.set_frameid(42);
+	m.set_timestamp(123456789);
+
+	auto buffer = pool.Serialize(m,42);
+	ASSERT_TRUE(buffer);
+	EXPECT_EQ(buffer->FrameID(),42);
+	// the buffer grows to fit the message.
+	EXPECT_GE(buffer->Capacity(),buffer->Size());
+
+	google::protobuf::io::CodedInputStream input(buffer->Data(),buffer->Size());
+	hermes::FrameReadout parsed;
+	ASSERT_TRUE(google::protobuf::util::ParseDelimitedFromCodedStream(&parsed,&input,nullptr));
+	EXPECT_EQ(parsed.frameid(),42);
+	EXPECT_EQ(parsed.timestamp(),123456789);
+	EXPECT_EQ(input.CurrentPosition(),buffer->Size());
+}
+
+TEST_F(MessageBufferUTest,RecyclesBuffers) {
+	MessageBufferPool pool(2);
+	hermes::FrameReadout m;
+
+	auto a = pool.Serialize(m,1);
+	auto b = pool.Serialize(m,2);
+	ASSERT_TRUE(a);
+	ASSERT_TRUE(b);
+	EXPECT_EQ(pool.Available(),0);
+	EXPECT_FALSE(pool.Serialize(m,3));
+
+	// shared references keep the buffer out of the pool.
+	auto c = a;
+	a.reset();
+	EXPECT_EQ(pool.Available(),0);
+	c.reset();
+	EXPECT_EQ(pool.Available(),1);
+
+	auto d = pool.Serialize(m,4);
+	ASSERT_TRUE(d);
+	EXPECT_EQ(d->FrameID(),4);
+	EXPECT_EQ(pool.Count(),2);
+}
+
+} // namespace artemis
+} // namespace fort
@@ -25,9 +25,11 @@ public:
 		if ( d_pool->try_pop(obj) == false ) {
 			obj = std::make_shared<T>(args...);
 		}
+		// objects keep their pool alive, they may outlive this
+		// ObjectPool.
 		return TPtr(obj.get(),
-		            [this,obj](T*){
-			            d_pool->push(obj);
+		            [pool = d_pool,obj](T*){
+			            pool->push(obj);
 		            });
 	}
 
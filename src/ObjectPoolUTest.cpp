@@ -75,5 +75,16 @@ TEST_F(ObjectPoolUTest,IsCopyable) {
 
 }
 
+TEST_F(ObjectPoolUTest,ObjectsCanOutliveThePool) {
+	std::shared_ptr<Object> o;
+	{
+		ObjectPool<Object> pool;
+		o = pool.Get(1);
+	}
+	EXPECT_EQ(o->Value(),1);
+	o.reset();
+	EXPECT_EQ(Object::CurrentlyAllocated(),0);
+}
+
 } // namespace artemis
 } // namespace fort
@@ -1,5 +1,7 @@
 #include "Options.hpp"
 
+#include "Connection.hpp"
+
 #include <stdexcept>
 
 
@@ -62,6 +64,33 @@ std::vector<size_t> ParseCommaSeparatedList(std::string & list) {
 	return res;
 }
 
+ProcessOptions::FramePolicy ParseFramePolicy(const std::string & policy) {
+	static std::map<std::string,ProcessOptions::FramePolicy> policies
+		= {
+		   {"latest",ProcessOptions::FramePolicy::LatestWins},
+		   {"oldest",ProcessOptions::FramePolicy::OldestWins},
+		   {"block",ProcessOptions::FramePolicy::Blocking},
+	};
+	auto fi = policies.find(policy);
+	if ( fi == policies.end() ) {
+		throw std::out_of_range("Unknown frame queue policy '" + policy + "'");
+	}
+	return fi->second;
+}
+
+RealTimeOptions::SchedulingPolicy ParseSchedulingPolicy(const std::string & policy) {
+	static std::map<std::string,RealTimeOptions::SchedulingPolicy> policies
+		= {
+		   {"fifo",RealTimeOptions::SchedulingPolicy::FIFO},
+		   {"rr",RealTimeOptions::SchedulingPolicy::RoundRobin},
+	};
+	auto fi = policies.find(policy);
+	if ( fi == policies.end() ) {
+		throw std::out_of_range("Unknown real-time scheduling policy '" + policy + "'");
+	}
+	return fi->second;
+}
+
 fort::tags::Family ParseTagFamily(const std::string & f) {
 	static std::map<std::string,fort::tags::Family> families
 		= {
@@ -91,6 +120,8 @@ GeneralOptions::GeneralOptions()
 	, PrintVersion(false)
 	, PrintResolution(false)
 	, LogDir("")
+	, RawReplayPath("")
+	, ReplayAsFastAsPossible(false)
 	, TestMode(false)
 	, LegacyMode(false) {
 }
@@ -101,6 +132,8 @@ void GeneralOptions::PopulateParser(options::FlagParser & parser) {
 	parser.AddFlag("version",PrintVersion,"Print version");
 	parser.AddFlag("log-output-dir",LogDir,"Directory to put logs in");
 	parser.AddFlag("stub-image-paths", stubImagePaths, "Use a suite of stub images instead of an actual framegrabber");
+	parser.AddFlag("raw-replay", RawReplayPath, "Replays a raw frame recording, a single segment file or a whole recording directory, instead of using an actual framegrabber");
+	parser.AddFlag("raw-replay-as-fast-as-possible", ReplayAsFastAsPossible, "Replays the raw frame recording as fast as it is processed instead of at its recorded pace. Use with '--frame-queue-policy block' to not drop any frame");
 	parser.AddFlag("test-mode",TestMode,"Test mode, adds an overlay detection drawing and statistics");
 	parser.AddFlag("legacy-mode",LegacyMode,"Uses a legacy mode data output for ants cataloging and video output display. The data will be convertible to the data expected by the former Keller's group tracking system");
 }
@@ -115,12 +148,26 @@ void GeneralOptions::FinishParse() {
 
 NetworkOptions::NetworkOptions()
 	: Host()
-	, Port(3002) {
+	, Port(3002)
+	, MaxBatchSize(64 * 1024)
+	, SpoolPath()
+	, SpoolSize(64 * 1024 * 1024)
+	, SpoolReplayRate(1024 * 1024)
+	, ServePort(0)
+	, ServeMaxSubscribers(8)
+	, ServeBacklog(64) {
 }
 
 void NetworkOptions::PopulateParser(options::FlagParser & parser) {
-	parser.AddFlag("host", Host, "Host to send tag detection readout");
+	parser.AddFlag("host", Host, "Host to send tag detection readout, or shm://<name> to publish them in shared memory");
 	parser.AddFlag("port", Port, "Port to send tag detection readout",'p');
+	parser.AddFlag("network-max-batch", MaxBatchSize, "Maximum size in bytes of readouts sent in a single write");
+	parser.AddFlag("network-spool", SpoolPath, "File to spool readouts to while disconnected, replayed once reconnected");
+	parser.AddFlag("network-spool-size", SpoolSize, "Maximum size in bytes of the readout spool");
+	parser.AddFlag("network-spool-replay-rate", SpoolReplayRate, "Rate in bytes per second at which spooled readouts are replayed, 0 for no limit");
+	parser.AddFlag("serve-port", ServePort, "Port to accept readout subscribers on, 0 to disable");
+	parser.AddFlag("serve-max-subscribers", ServeMaxSubscribers, "Maximum number of readout subscribers");
+	parser.AddFlag("serve-backlog", ServeBacklog, "Number of readouts kept for a slow subscriber before dropping the oldest");
 }
 
 void NetworkOptions::FinishParse() {}
@@ -144,7 +191,8 @@ cv::Size VideoOutputOptions::WorkingResolution(const cv::Size & input) const {
 	return cv::Size(input.width * double(Height) / double(input.height),Height);
 }
 
-DisplayOptions::DisplayOptions() {
+DisplayOptions::DisplayOptions()
+	: Headless(false) {
 }
 
 void DisplayOptions::PopulateParser(options::FlagParser & parser) {
@@ -162,7 +210,9 @@ ProcessOptions::ProcessOptions()
 	, UUID()
 	, NewAntOutputDir()
 	, NewAntROISize(600)
-	, ImageRenewPeriod(2 * Duration::Hour) {
+	, ImageRenewPeriod(2 * Duration::Hour)
+	, QueuePolicy(FramePolicy::LatestWins)
+	, d_queuePolicy("latest") {
 	d_imageRenewPeriod = ImageRenewPeriod.ToString();
 }
 
@@ -173,6 +223,7 @@ void ProcessOptions::PopulateParser(options::FlagParser & parser) {
 	parser.AddFlag("new-ant-roi-size", NewAntROISize, "Size of the image to save when a new ant is found");
 	parser.AddFlag("image-renew-period", d_imageRenewPeriod, "ant cataloguing and full frame export renew period");
 	parser.AddFlag("uuid", UUID,"The UUID to mark data sent over network");
+	parser.AddFlag("frame-queue-policy", d_queuePolicy,"Frames to drop when processing is late: 'latest' drops queued frames to process the newest one, 'oldest' drops new frames while the queue is full, 'block' waits for processing and should only be used for replays");
 }
 
 void ProcessOptions::FinishParse() {
@@ -180,12 +231,101 @@ void ProcessOptions::FinishParse() {
 	FrameID.clear();
 	FrameID.insert(IDs.begin(),IDs.end());
 	ImageRenewPeriod = Duration::Parse(d_imageRenewPeriod);
+	QueuePolicy = ParseFramePolicy(d_queuePolicy);
+}
+
+SyntheticOptions::SyntheticOptions()
+	: Tags(0)
+	, TagSize(80)
+	, Width(2048)
+	, Height(1536)
+	, Motion(0.0)
+	, Noise(8.0) {
+}
+
+void SyntheticOptions::PopulateParser(options::FlagParser & parser) {
+	parser.AddFlag("synthetic-tags",Tags,"Renders this number of tags of the --at-family in synthetic frames instead of using an actual framegrabber");
+	parser.AddFlag("synthetic-tag-size",TagSize,"Size in pixels of the synthetic tags, including their white border");
+	parser.AddFlag("synthetic-width",Width,"Width of the synthetic frames");
+	parser.AddFlag("synthetic-height",Height,"Height of the synthetic frames");
+	parser.AddFlag("synthetic-motion",Motion,"Distance in pixels synthetic tags move between two frames");
+	parser.AddFlag("synthetic-noise",Noise,"Standard deviation of the gaussian noise added to synthetic frames");
+}
+
+void SyntheticOptions::FinishParse() {
+}
+
+RecordOptions::RecordOptions()
+	: OutputDir("")
+	, Stride(1)
+	, SegmentFrames(1000)
+	, QueueSize(8) {
+}
+
+void RecordOptions::PopulateParser(options::FlagParser & parser) {
+	parser.AddFlag("record-raw-dir",OutputDir,"Directory where to record the raw frames, for later replay with --raw-replay");
+	parser.AddFlag("record-raw-stride",Stride,"Only records one frame every stride");
+	parser.AddFlag("record-raw-segment-frames",SegmentFrames,"Number of frames per recording file");
+	parser.AddFlag("record-raw-queue-size",QueueSize,"Number of frames that can wait to be written, further frames are dropped from the recording");
+}
+
+void RecordOptions::FinishParse() {
+	if ( Stride == 0 ) {
+		Stride = 1;
+	}
+}
+
+PlacementOptions::PlacementOptions()
+	: Disabled(false)
+	, Package(0) {
+}
+
+void PlacementOptions::PopulateParser(options::FlagParser & parser) {
+	parser.AddFlag("cpu-no-pinning",Disabled,"Lets the kernel place all threads, instead of pinning them to cores");
+	parser.AddFlag("cpu-package",Package,"CPU package (socket) the framegrabber is attached to, which runs acquisition and detection");
+	parser.AddFlag("cpu-acquisition",AcquisitionCPUs,"CPUs for acquisition threads, e.g. '0' or '0,2-3'. Automatic by default");
+	parser.AddFlag("cpu-detection",DetectionCPUs,"CPUs for processing and detection threads. Automatic by default");
+	parser.AddFlag("cpu-service",ServiceCPUs,"CPUs for IO, video output, user interface and background threads. Automatic by default");
+}
+
+void PlacementOptions::FinishParse() {}
+
+RealTimeOptions::RealTimeOptions()
+	: Policy(SchedulingPolicy::FIFO)
+	, AcquisitionPriority(0)
+	, ProcessPriority(0)
+	, NoMemoryLock(false)
+	, d_policy("fifo") {
+}
+
+void RealTimeOptions::PopulateParser(options::FlagParser & parser) {
+	parser.AddFlag("rt-policy",d_policy,"Real-time scheduling policy: 'fifo' or 'rr'");
+	parser.AddFlag("rt-acquisition-priority",AcquisitionPriority,"Real-time priority [1-99] of acquisition threads. 0 keeps the normal scheduling");
+	parser.AddFlag("rt-process-priority",ProcessPriority,"Real-time priority [1-99] of processing threads. 0 keeps the normal scheduling");
+	parser.AddFlag("rt-no-memory-lock",NoMemoryLock,"Does not lock memory in RAM when using real-time scheduling");
+}
+
+void RealTimeOptions::FinishParse() {
+	Policy = ParseSchedulingPolicy(d_policy);
+	for ( auto priority : {AcquisitionPriority,ProcessPriority} ) {
+		if ( priority < 0 || priority > 99 ) {
+			throw std::invalid_argument("Real-time priority " + std::to_string(priority)
+			                            + " is outside of [0;99]");
+		}
+	}
+}
+
+bool RealTimeOptions::Enabled() const {
+	return AcquisitionPriority > 0 || ProcessPriority > 0;
 }
 
 CameraOptions::CameraOptions()
 	: FPS(8.0)
 	, StrobeDuration(1500 * Duration::Microsecond)
-	, StrobeDelay(0) {
+	, StrobeDelay(0)
+	, Buffers(4)
+	, Count(1)
+	, Index(0) {
 	d_strobeDuration = StrobeDuration.ToString();
 	d_strobeDelay = StrobeDelay.ToString();
 }
@@ -196,6 +336,8 @@ void CameraOptions::PopulateParser(options::FlagParser & parser)  {
 	parser.AddFlag("camera-slave-height",SlaveHeight,"Camera Height argument for slave mode");
 	parser.AddFlag("camera-strobe",d_strobeDuration,"Camera Strobe duration");
 	parser.AddFlag("camera-strobe-delay",d_strobeDelay,"Camera Strobe delay");
+	parser.AddFlag("camera-buffers",Buffers,"Number of framegrabber buffers. Acquisition overruns when processing holds all of them");
+	parser.AddFlag("camera-count",Count,"Number of cameras driven by this process. Camera i sends its readouts to port + i, and only the first one is displayed");
 }
 
 void CameraOptions::FinishParse() {
@@ -213,7 +355,12 @@ ApriltagOptions::ApriltagOptions()
 	, QuadCriticalRadian(0.174533)
 	, QuadMaxLineMSE(10.0)
 	, QuadMinBWDiff(40)
-	, QuadDeglitch(false) {
+	, QuadDeglitch(false)
+	, TagSize(150)
+	, AdaptiveQuality(false)
+	, MaskPath("")
+	, TrackingSweepPeriod(0)
+	, TrackingWindowSize(200) {
  }
 
 void ApriltagOptions::PopulateParser(options::FlagParser & parser)  {
@@ -227,6 +374,11 @@ void ApriltagOptions::PopulateParser(options::FlagParser & parser)  {
 	parser.AddFlag("at-quad-min-bw-diff",QuadMinBWDiff,"Difference in pixel value to consider a region black or white");
 	parser.AddFlag("at-quad-deglitch",QuadDeglitch,"Deglitch only for noisy images");
 	parser.AddFlag("at-family",d_family,"The apriltag family to use");
+	parser.AddFlag("at-tag-size",TagSize,"Largest extent in pixels of a tag in the image, used to size the overlapping detection tiles");
+	parser.AddFlag("at-adaptive-quality",AdaptiveQuality,"Lowers the detection quality (decimation, blurring and edge refinement) when detection does not fit in the camera frame period, instead of dropping frames");
+	parser.AddFlag("at-mask",MaskPath,"Path to a grayscale image of the frame size. Tags are never searched where it is black, e.g. walls or outside of the nest");
+	parser.AddFlag("at-tracking-sweep-period",TrackingSweepPeriod,"Only search around previously detected tags, and sweep the full frame in a rotating band over this number of frames. 0 disables tracking-guided detection");
+	parser.AddFlag("at-tracking-window",TrackingWindowSize,"Size in pixels of the grid cells searched, with their neighbours, around each previously detected tag");
 }
 
 void ApriltagOptions::FinishParse() {
@@ -242,6 +394,10 @@ void Options::PopulateParser(options::FlagParser & parser)  {
 	Apriltag.PopulateParser(parser);
 	Camera.PopulateParser(parser);
 	Process.PopulateParser(parser);
+	Record.PopulateParser(parser);
+	Synthetic.PopulateParser(parser);
+	Placement.PopulateParser(parser);
+	RealTime.PopulateParser(parser);
 }
 
 void Options::FinishParse()  {
@@ -252,6 +408,10 @@ void Options::FinishParse()  {
 	Apriltag.FinishParse();
 	Camera.FinishParse();
 	Process.FinishParse();
+	Record.FinishParse();
+	Synthetic.FinishParse();
+	Placement.FinishParse();
+	RealTime.FinishParse();
 }
 
 Options Options::Parse(int & argc, char ** argv, bool printHelp) {
@@ -274,6 +434,40 @@ Options Options::Parse(int & argc, char ** argv, bool printHelp) {
 }
 
 
+Options Options::ForCamera(size_t index) const {
+	if ( index >= Camera.Count ) {
+		throw std::out_of_range("Camera index " + std::to_string(index)
+		                        + " is out of range [0;" + std::to_string(Camera.Count) + "[");
+	}
+	Options res = *this;
+	res.Camera.Index = index;
+	if ( Camera.Count == 1 ) {
+		return res;
+	}
+	std::string subDir = "/camera-" + std::to_string(index);
+	res.Network.Port += index;
+	if ( Network.ServePort != 0 ) {
+		res.Network.ServePort += index;
+	}
+	if ( base::HasPrefix(Network.Host,Connection::SHARED_MEMORY_PREFIX) == true ) {
+		res.Network.Host += ".camera-" + std::to_string(index);
+	}
+	if ( Record.OutputDir.empty() == false ) {
+		res.Record.OutputDir += subDir;
+	}
+	if ( Process.NewAntOutputDir.empty() == false ) {
+		res.Process.NewAntOutputDir += subDir;
+	}
+	if ( Network.SpoolPath.empty() == false ) {
+		res.Network.SpoolPath += ".camera-" + std::to_string(index);
+	}
+	if ( index > 0 ) {
+		res.Display.Headless = true;
+		res.VideoOutput.ToStdout = false;
+	}
+	return res;
+}
+
 void Options::Validate() {
 
 	if ( Process.FrameStride == 0 ) {
@@ -295,6 +489,20 @@ void Options::Validate() {
 
 		}
 	}
+
+	if ( Camera.Count == 0 ) {
+		throw std::invalid_argument("At least one camera is needed (--camera-count)");
+	}
+
+	if ( Network.Host == Connection::SHARED_MEMORY_PREFIX ) {
+		throw std::invalid_argument("Shared memory readouts need a name (--host "
+		                            + std::string(Connection::SHARED_MEMORY_PREFIX) + "<name>)");
+	}
+
+	if ( Synthetic.Tags > 0 && Apriltag.Family == fort::tags::Family::Undefined ) {
+		throw std::invalid_argument("Synthetic frames need a tag family (--at-family)");
+	}
+
 #ifdef NDEBUG
 	if ( Process.ImageRenewPeriod < 15 * Duration::Minute ) {
 		throw std::invalid_argument("Image renew period (" + Process.ImageRenewPeriod.ToString() + ") is too small for production of large dataset (minimum: 15m)");
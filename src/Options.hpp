@@ -25,6 +25,8 @@ struct GeneralOptions {
 
 	std::string LogDir;
 	std::vector<std::string> StubImagePaths;
+	std::string RawReplayPath;
+	bool        ReplayAsFastAsPossible;
 
 	bool        TestMode;
 	bool        LegacyMode;
@@ -37,6 +39,8 @@ struct DisplayOptions {
 	DisplayOptions();
 
 	std::vector<uint32_t> Highlighted;
+	// set for all cameras but the first one, which owns the window.
+	bool                  Headless;
 
 	void PopulateParser( options::FlagParser & parser);
 	void FinishParse();
@@ -53,6 +57,13 @@ struct NetworkOptions {
 
 	std::string Host;
 	uint16_t    Port;
+	size_t      MaxBatchSize;
+	std::string SpoolPath;
+	size_t      SpoolSize;
+	size_t      SpoolReplayRate;
+	uint16_t    ServePort;
+	size_t      ServeMaxSubscribers;
+	size_t      ServeBacklog;
 };
 
 struct VideoOutputOptions {
@@ -85,6 +96,12 @@ struct ApriltagOptions {
 	float        QuadMaxLineMSE;
 	int          QuadMinBWDiff;
 	bool         QuadDeglitch;
+	size_t       TagSize;
+	bool         AdaptiveQuality;
+	std::string  MaskPath;
+
+	size_t       TrackingSweepPeriod;
+	size_t       TrackingWindowSize;
 
 private:
 	std::string d_family;
@@ -100,12 +117,29 @@ struct CameraOptions {
 	Duration  StrobeDelay;
 	size_t    SlaveWidth;
 	size_t    SlaveHeight;
+	size_t    Buffers;
+	size_t    Count;
+	// Index of the camera driven with these options, among Count.
+	size_t    Index;
 private:
 	std::string d_strobeDuration,d_strobeDelay;
 };
 
 
 struct ProcessOptions {
+	// Which frames are dropped when processing cannot keep up with
+	// acquisition.
+	enum class FramePolicy {
+		// stale queued frames are dropped, the newest is processed.
+		LatestWins = 0,
+		// queued frames are all processed, new frames are dropped
+		// while the queue is full.
+		OldestWins,
+		// acquisition waits for room in the queue, no frame is
+		// dropped. Only meaningful when replaying a recording.
+		Blocking,
+	};
+
 	ProcessOptions();
 	void PopulateParser( options::FlagParser & parser);
  	void FinishParse();
@@ -118,8 +152,69 @@ struct ProcessOptions {
 	std::string NewAntOutputDir;
 	size_t      NewAntROISize;
 	Duration    ImageRenewPeriod;
+	FramePolicy QueuePolicy;
+private:
+	std::string d_imageRenewPeriod,d_frameIDs,d_queuePolicy;
+};
+
+struct SyntheticOptions {
+	SyntheticOptions();
+	void PopulateParser( options::FlagParser & parser);
+ 	void FinishParse();
+
+	size_t Tags;
+	size_t TagSize;
+	size_t Width;
+	size_t Height;
+	double Motion;
+	double Noise;
+};
+
+struct RecordOptions {
+	RecordOptions();
+	void PopulateParser( options::FlagParser & parser);
+ 	void FinishParse();
+
+	std::string OutputDir;
+	size_t      Stride;
+	size_t      SegmentFrames;
+	size_t      QueueSize;
+};
+
+struct PlacementOptions {
+	PlacementOptions();
+	void PopulateParser( options::FlagParser & parser);
+ 	void FinishParse();
+
+	bool        Disabled;
+	// package the framegrabber is attached to.
+	size_t      Package;
+	// CPU lists, like "0,2-5", overriding the automatic placement.
+	std::string AcquisitionCPUs;
+	std::string DetectionCPUs;
+	std::string ServiceCPUs;
+};
+
+struct RealTimeOptions {
+	enum class SchedulingPolicy {
+		FIFO = 0,
+		RoundRobin,
+	};
+
+	RealTimeOptions();
+	void PopulateParser( options::FlagParser & parser);
+ 	void FinishParse();
+
+	// Real-time is opt-in: a zero priority keeps the normal
+	// scheduling for the thread.
+	bool Enabled() const;
+
+	SchedulingPolicy Policy;
+	int              AcquisitionPriority;
+	int              ProcessPriority;
+	bool             NoMemoryLock;
 private:
-	std::string d_imageRenewPeriod,d_frameIDs;
+	std::string d_policy;
 };
 
 struct Options {
@@ -130,9 +225,19 @@ struct Options {
 	ApriltagOptions    Apriltag;
 	CameraOptions      Camera;
 	ProcessOptions     Process;
+	RecordOptions      Record;
+	SyntheticOptions   Synthetic;
+	PlacementOptions   Placement;
+	RealTimeOptions    RealTime;
 
 	static Options Parse(int & argc, char ** argv, bool printHelp = false);
 
+	// Options for one of the Camera.Count cameras. The first camera
+	// keeps the user interface and video output. Each camera sends
+	// its readouts to its own port, Network.Port + index, and records
+	// in its own sub-directory.
+	Options ForCamera(size_t index) const;
+
 	void Validate();
 
 private :
@@ -15,14 +15,24 @@ TEST_F(OptionsUTest,DefaultValues) {
 	EXPECT_EQ(options.General.PrintResolution,false);
 	EXPECT_EQ(options.General.LogDir,"");
 	EXPECT_TRUE(options.General.StubImagePaths.empty());
+	EXPECT_EQ(options.General.RawReplayPath,"");
+	EXPECT_EQ(options.General.ReplayAsFastAsPossible,false);
 	EXPECT_EQ(options.General.TestMode,false);
 	EXPECT_EQ(options.General.LegacyMode,false);
 
 	EXPECT_TRUE(options.Display.Highlighted.empty());
+	EXPECT_EQ(options.Display.Headless,false);
 
 
 	EXPECT_EQ(options.Network.Host,"");
 	EXPECT_EQ(options.Network.Port,3002);
+	EXPECT_EQ(options.Network.MaxBatchSize,64 * 1024);
+	EXPECT_EQ(options.Network.SpoolPath,"");
+	EXPECT_EQ(options.Network.SpoolSize,64 * 1024 * 1024);
+	EXPECT_EQ(options.Network.SpoolReplayRate,1024 * 1024);
+	EXPECT_EQ(options.Network.ServePort,0);
+	EXPECT_EQ(options.Network.ServeMaxSubscribers,8);
+	EXPECT_EQ(options.Network.ServeBacklog,64);
 
 	EXPECT_EQ(options.VideoOutput.Height,1080);
 	EXPECT_EQ(options.VideoOutput.AddHeader,false);
@@ -38,10 +48,18 @@ TEST_F(OptionsUTest,DefaultValues) {
 	EXPECT_FLOAT_EQ(options.Apriltag.QuadMaxLineMSE,10.0);
 	EXPECT_EQ(options.Apriltag.QuadMinBWDiff,40);
 	EXPECT_EQ(options.Apriltag.QuadDeglitch,false);
+	EXPECT_EQ(options.Apriltag.TagSize,150);
+	EXPECT_EQ(options.Apriltag.AdaptiveQuality,false);
+	EXPECT_EQ(options.Apriltag.MaskPath,"");
+	EXPECT_EQ(options.Apriltag.TrackingSweepPeriod,0);
+	EXPECT_EQ(options.Apriltag.TrackingWindowSize,200);
 
 	EXPECT_FLOAT_EQ(options.Camera.FPS,8.0);
 	EXPECT_EQ(options.Camera.StrobeDuration,1500 * Duration::Microsecond);
 	EXPECT_EQ(options.Camera.StrobeDelay,0);
+	EXPECT_EQ(options.Camera.Buffers,4);
+	EXPECT_EQ(options.Camera.Count,1);
+	EXPECT_EQ(options.Camera.Index,0);
 
 	EXPECT_EQ(options.Process.FrameStride,1);
 	EXPECT_TRUE(options.Process.FrameID.empty());
@@ -49,6 +67,31 @@ TEST_F(OptionsUTest,DefaultValues) {
 	EXPECT_EQ(options.Process.NewAntROISize,600);
 	EXPECT_EQ(options.Process.ImageRenewPeriod,2 * Duration::Hour);
 	EXPECT_EQ(options.Process.UUID,"");
+	EXPECT_EQ(options.Process.QueuePolicy,ProcessOptions::FramePolicy::LatestWins);
+
+	EXPECT_EQ(options.Record.OutputDir,"");
+	EXPECT_EQ(options.Record.Stride,1);
+	EXPECT_EQ(options.Record.SegmentFrames,1000);
+	EXPECT_EQ(options.Record.QueueSize,8);
+
+	EXPECT_EQ(options.Synthetic.Tags,0);
+	EXPECT_EQ(options.Synthetic.TagSize,80);
+	EXPECT_EQ(options.Synthetic.Width,2048);
+	EXPECT_EQ(options.Synthetic.Height,1536);
+	EXPECT_DOUBLE_EQ(options.Synthetic.Motion,0.0);
+	EXPECT_DOUBLE_EQ(options.Synthetic.Noise,8.0);
+
+	EXPECT_EQ(options.Placement.Disabled,false);
+	EXPECT_EQ(options.Placement.Package,0);
+	EXPECT_EQ(options.Placement.AcquisitionCPUs,"");
+	EXPECT_EQ(options.Placement.DetectionCPUs,"");
+	EXPECT_EQ(options.Placement.ServiceCPUs,"");
+
+	EXPECT_EQ(options.RealTime.Policy,RealTimeOptions::SchedulingPolicy::FIFO);
+	EXPECT_EQ(options.RealTime.AcquisitionPriority,0);
+	EXPECT_EQ(options.RealTime.ProcessPriority,0);
+	EXPECT_EQ(options.RealTime.NoMemoryLock,false);
+	EXPECT_FALSE(options.RealTime.Enabled());
 
 }
 
@@ -85,6 +128,11 @@ TEST_F(OptionsUTest,TestParse) {
 				    EXPECT_EQ(options.General.StubImagePaths[2],"baz");
 			    }
 		    }},
+		   {{"artemis","--raw-replay","foo.raw","--raw-replay-as-fast-as-possible"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.General.RawReplayPath,"foo.raw");
+			    EXPECT_TRUE(options.General.ReplayAsFastAsPossible);
+		    }},
 		   {{"artemis","--test-mode"},
 		    [](const Options & options) {
 			    EXPECT_TRUE(options.General.TestMode);
@@ -101,6 +149,26 @@ TEST_F(OptionsUTest,TestParse) {
 		    [](const Options & options) {
 			    EXPECT_EQ(options.Network.Port,1234);
 		    }},
+		   {{"artemis","--network-max-batch", "4096"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Network.MaxBatchSize,4096);
+		    }},
+		   {{"artemis","--network-spool", "/data/readouts.spool",
+		     "--network-spool-size", "1048576",
+		     "--network-spool-replay-rate", "0"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Network.SpoolPath,"/data/readouts.spool");
+			    EXPECT_EQ(options.Network.SpoolSize,1048576);
+			    EXPECT_EQ(options.Network.SpoolReplayRate,0);
+		    }},
+		   {{"artemis","--serve-port", "3010",
+		     "--serve-max-subscribers", "2",
+		     "--serve-backlog", "16"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Network.ServePort,3010);
+			    EXPECT_EQ(options.Network.ServeMaxSubscribers,2);
+			    EXPECT_EQ(options.Network.ServeBacklog,16);
+		    }},
 		   {{"artemis","--uuid", "abcdef123456"},
 		    [](const Options & options) {
 			    EXPECT_EQ(options.Process.UUID,"abcdef123456");
@@ -142,6 +210,39 @@ TEST_F(OptionsUTest,TestParse) {
 			    }
 		    }},
 
+		   {{"artemis","--frame-queue-policy", "oldest"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Process.QueuePolicy,ProcessOptions::FramePolicy::OldestWins);
+		    }},
+		   {{"artemis","--frame-queue-policy", "block"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Process.QueuePolicy,ProcessOptions::FramePolicy::Blocking);
+		    }},
+		   {{"artemis","--record-raw-dir", "foo",
+		     "--record-raw-stride", "3",
+		     "--record-raw-segment-frames", "100",
+		     "--record-raw-queue-size", "2"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Record.OutputDir,"foo");
+			    EXPECT_EQ(options.Record.Stride,3);
+			    EXPECT_EQ(options.Record.SegmentFrames,100);
+			    EXPECT_EQ(options.Record.QueueSize,2);
+		    }},
+		   {{"artemis","--synthetic-tags", "50", "--at-family", "36h11",
+		     "--synthetic-tag-size", "60",
+		     "--synthetic-width", "1000",
+		     "--synthetic-height", "800",
+		     "--synthetic-motion", "2.5",
+		     "--synthetic-noise", "4"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Synthetic.Tags,50);
+			    EXPECT_EQ(options.Synthetic.TagSize,60);
+			    EXPECT_EQ(options.Synthetic.Width,1000);
+			    EXPECT_EQ(options.Synthetic.Height,800);
+			    EXPECT_DOUBLE_EQ(options.Synthetic.Motion,2.5);
+			    EXPECT_DOUBLE_EQ(options.Synthetic.Noise,4.0);
+		    }},
+
 		   {{"artemis","--new-ant-output-dir", "foo"},
 		    [](const Options & options) {
 			    EXPECT_EQ(options.Process.NewAntOutputDir,"foo");
@@ -182,6 +283,48 @@ TEST_F(OptionsUTest,TestParse) {
 			    EXPECT_EQ(options.Camera.SlaveHeight,6004);
 		    }},
 
+		   {{"artemis","--camera-buffers", "32"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Camera.Buffers,32);
+		    }},
+
+		   {{"artemis","--camera-count", "3"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Camera.Count,3);
+		    }},
+
+		   {{"artemis","--cpu-no-pinning"},
+		    [](const Options & options) {
+			    EXPECT_TRUE(options.Placement.Disabled);
+		    }},
+
+		   {{"artemis","--cpu-package", "1"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Placement.Package,1);
+		    }},
+
+		   {{"artemis","--cpu-acquisition", "0", "--cpu-detection", "2-7", "--cpu-service", "1,8"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Placement.AcquisitionCPUs,"0");
+			    EXPECT_EQ(options.Placement.DetectionCPUs,"2-7");
+			    EXPECT_EQ(options.Placement.ServiceCPUs,"1,8");
+		    }},
+
+		   {{"artemis","--rt-policy", "rr", "--rt-acquisition-priority", "80"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.RealTime.Policy,RealTimeOptions::SchedulingPolicy::RoundRobin);
+			    EXPECT_EQ(options.RealTime.AcquisitionPriority,80);
+			    EXPECT_EQ(options.RealTime.ProcessPriority,0);
+			    EXPECT_TRUE(options.RealTime.Enabled());
+		    }},
+
+		   {{"artemis","--rt-process-priority", "60", "--rt-no-memory-lock"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.RealTime.ProcessPriority,60);
+			    EXPECT_TRUE(options.RealTime.NoMemoryLock);
+			    EXPECT_TRUE(options.RealTime.Enabled());
+		    }},
+
 		   {{"artemis","--at-quad-decimate", "1.5"},
 		    [](const Options & options) {
 			    EXPECT_FLOAT_EQ(options.Apriltag.QuadDecimate,1.5);
@@ -231,6 +374,31 @@ TEST_F(OptionsUTest,TestParse) {
 		    [](const Options & options) {
 		   	    EXPECT_EQ(options.Apriltag.Family,fort::tags::Family::Tag36ARTag);
 		    }},
+
+		   {{"artemis","--at-tag-size", "100"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Apriltag.TagSize,100);
+		    }},
+
+		   {{"artemis","--at-adaptive-quality"},
+		    [](const Options & options) {
+			    EXPECT_TRUE(options.Apriltag.AdaptiveQuality);
+		    }},
+
+		   {{"artemis","--at-mask", "/tmp/mask.png"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Apriltag.MaskPath,"/tmp/mask.png");
+		    }},
+
+		   {{"artemis","--at-tracking-sweep-period", "8"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Apriltag.TrackingSweepPeriod,8);
+		    }},
+
+		   {{"artemis","--at-tracking-window", "150"},
+		    [](const Options & options) {
+			    EXPECT_EQ(options.Apriltag.TrackingWindowSize,150);
+		    }},
 	};
 
 
@@ -272,6 +440,32 @@ TEST_F(OptionsUTest,TestValidation) {
 	} catch ( const std::invalid_argument &  e ) {
 		EXPECT_STREQ(e.what(),"3 is outside of frame stride range [0;3[");
 	}
+	options.Process.FrameID.clear();
+	options.Synthetic.Tags = 10;
+	try {
+		options.Validate();
+		ADD_FAILURE() << "Should have thrown an invalid argument";
+	} catch ( const std::invalid_argument &  e ) {
+		EXPECT_STREQ(e.what(),"Synthetic frames need a tag family (--at-family)");
+	}
+	options.Synthetic.Tags = 0;
+	options.Camera.Count = 0;
+	try {
+		options.Validate();
+		ADD_FAILURE() << "Should have thrown an invalid argument";
+	} catch ( const std::invalid_argument &  e ) {
+		EXPECT_STREQ(e.what(),"At least one camera is needed (--camera-count)");
+	}
+	options.Camera.Count = 1;
+	options.Network.Host = "shm://";
+	try {
+		options.Validate();
+		ADD_FAILURE() << "Should have thrown an invalid argument";
+	} catch ( const std::invalid_argument &  e ) {
+		EXPECT_STREQ(e.what(),"Shared memory readouts need a name (--host shm://<name>)");
+	}
+	options.Network.Host = "shm://artemis";
+	EXPECT_NO_THROW({options.Validate();});
 #ifdef NDEBUG
 	options.Process.FrameID.clear();
 	options.Process.ImageRenewPeriod = 1 *  Duration::Second;
@@ -285,5 +479,42 @@ TEST_F(OptionsUTest,TestValidation) {
 #endif
 }
 
+TEST_F(OptionsUTest,ForCamera) {
+	Options options;
+	options.Network.Port = 4000;
+	options.VideoOutput.ToStdout = true;
+	options.Record.OutputDir = "/data/raw";
+	options.Network.SpoolPath = "/data/readouts.spool";
+	options.Network.ServePort = 3010;
+	options.Network.Host = "shm://artemis";
+
+	auto single = options.ForCamera(0);
+	EXPECT_EQ(single.Network.Port,4000);
+	EXPECT_EQ(single.Record.OutputDir,"/data/raw");
+	EXPECT_EQ(single.Network.SpoolPath,"/data/readouts.spool");
+	EXPECT_EQ(single.Network.Host,"shm://artemis");
+	EXPECT_TRUE(single.VideoOutput.ToStdout);
+	EXPECT_THROW({options.ForCamera(1);},std::out_of_range);
+
+	options.Camera.Count = 2;
+	auto first = options.ForCamera(0);
+	EXPECT_EQ(first.Camera.Index,0);
+	EXPECT_EQ(first.Network.Port,4000);
+	EXPECT_EQ(first.Record.OutputDir,"/data/raw/camera-0");
+	EXPECT_TRUE(first.VideoOutput.ToStdout);
+	EXPECT_FALSE(first.Display.Headless);
+
+	auto second = options.ForCamera(1);
+	EXPECT_EQ(second.Camera.Index,1);
+	EXPECT_EQ(second.Network.Port,4001);
+	EXPECT_EQ(second.Network.ServePort,3011);
+	EXPECT_EQ(second.Network.Host,"shm://artemis.camera-1");
+	EXPECT_EQ(second.Record.OutputDir,"/data/raw/camera-1");
+	EXPECT_EQ(second.Network.SpoolPath,"/data/readouts.spool.camera-1");
+	EXPECT_EQ(second.Process.NewAntOutputDir,"");
+	EXPECT_FALSE(second.VideoOutput.ToStdout);
+	EXPECT_TRUE(second.Display.Headless);
+}
+
 } // namespace artemis
 } // namespace fort
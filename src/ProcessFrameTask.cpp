@@ -1,17 +1,31 @@
 #include "ProcessFrameTask.hpp"
 
 #include <tbb/parallel_for.h>
+// oneTBB renamed the pipeline header and its filter modes.
+#if __has_include(<tbb/parallel_pipeline.h>)
+#include <tbb/parallel_pipeline.h>
+#define ARTEMIS_ONETBB_PIPELINE 1
+#else
+#include <tbb/pipeline.h>
+#endif
 
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
 
+#include <limits>
+
 #include <artemis-config.h>
 
 #include "Connection.hpp"
+#include "ReadoutServer.hpp"
 #include "ApriltagDetector.hpp"
+#include "QualityController.hpp"
+#include "LossLedger.hpp"
 #include "FullFrameExportTask.hpp"
+#include "RawFrameRecorderTask.hpp"
 #include "VideoOutputTask.hpp"
 #include "UserInterfaceTask.hpp"
+#include "SyntheticFrameGrabber.hpp"
 
 #include <glog/logging.h>
 
@@ -20,18 +34,35 @@
 namespace fort {
 namespace artemis {
 
+#ifdef ARTEMIS_ONETBB_PIPELINE
+static const auto SERIAL_IN_ORDER = tbb::filter_mode::serial_in_order;
+#else
+static const auto SERIAL_IN_ORDER = tbb::filter::serial_in_order;
+#endif
+
 ProcessFrameTask::ProcessFrameTask(const Options & options,
                                    boost::asio::io_context & context,
-                                   const cv::Size & inputResolution)
+                                   const cv::Size & inputResolution,
+                                   const ThreadBudget::Ptr & budget)
 	: d_options(options.Process)
-	, d_maximumThreads(cv::getNumThreads()) {
-	d_actualThreads = d_maximumThreads;
+	, d_lossLedger(std::make_shared<artemis::LossLedger>())
+	, d_frameQueue(ARTEMIS_FRAME_QUEUE_CAPACITY)
+	, d_droppedFrames(MAX_PENDING_DROPS)
+	, d_hasNextDropped(false)
+	, d_budget(budget)
+	, d_qualityLevel(0)
+	, d_maximumBacklog(0)
+	, d_frameDropped(0)
+	, d_frameProcessed(0)
+	, d_groundTruthTags(0)
+	, d_groundTruthDetected(0) {
 	d_workingResolution = options.VideoOutput.WorkingResolution(inputResolution);
 
-	SetUpDetection(inputResolution,options.Apriltag);
+	SetUpDetection(inputResolution,options);
 	SetUpUserInterface(d_workingResolution,inputResolution,options);
 	SetUpVideoOutputTask(options.VideoOutput,context,options.General.LegacyMode);
 	SetUpCataloguing(options.Process);
+	SetUpRecording(options.Record,inputResolution);
 	SetUpPoolObjects();
 	SetUpConnection(options.Network,context);
 
@@ -59,6 +90,14 @@ FullFrameExportTaskPtr 	ProcessFrameTask::FullFrameExportTask() const {
 	return d_fullFrameExport;
 }
 
+RawFrameRecorderTaskPtr ProcessFrameTask::RawFrameRecorderTask() const {
+	return d_recorder;
+}
+
+LossLedgerPtr ProcessFrameTask::LossLedger() const {
+	return d_lossLedger;
+}
+
 
 void ProcessFrameTask::SetUpVideoOutputTask(const VideoOutputOptions & options,
                                             boost::asio::io_context & context,
@@ -66,18 +105,33 @@ void ProcessFrameTask::SetUpVideoOutputTask(const VideoOutputOptions & options,
 	if ( options.ToStdout == false ) {
 		return;
 	}
-	d_videoOutput = std::make_shared<artemis::VideoOutputTask>(options,context,legacyMode);
+	d_videoOutput = std::make_shared<artemis::VideoOutputTask>(options,context,legacyMode,d_lossLedger);
 }
 
 void ProcessFrameTask::SetUpDetection(const cv::Size & inputResolution,
-                                      const ApriltagOptions & options) {
-	if ( options.Family == tags::Family::Undefined ) {
+                                      const Options & options) {
+	if ( options.Apriltag.Family == tags::Family::Undefined ) {
 		return;
 	}
-	d_detector = std::make_unique<ApriltagDetector>(d_maximumThreads,
+	d_detector = std::make_unique<ApriltagDetector>(d_budget->DetectionThreads(),
 	                                                inputResolution,
-	                                                options);
+	                                                options.Apriltag);
 
+	if ( options.Apriltag.AdaptiveQuality == false ) {
+		return;
+	}
+	// only a fraction of the frames are processed when using a frame
+	// stride, they can use more than one frame period.
+	double processedRatio = double(std::max(options.Process.FrameID.size(),size_t(1)))
+		/ double(std::max(options.Process.FrameStride,size_t(1)));
+	Duration budget(int64_t(1.0e9 / options.Camera.FPS / processedRatio));
+	LOG(INFO) << "Adaptive detection quality, budget: " << budget
+	          << ", levels: " << d_detector->QualityLevels();
+	d_qualityController = std::make_unique<QualityController>(budget,
+	                                                          d_detector->QualityLevels());
+	// we tolerate a frame waiting in the queue, as the controller
+	// will lower the quality to catch up.
+	d_maximumBacklog = 1;
 }
 void ProcessFrameTask::SetUpCataloguing(const ProcessOptions & options) {
 	if ( options.NewAntOutputDir.empty() ) {
@@ -87,21 +141,51 @@ void ProcessFrameTask::SetUpCataloguing(const ProcessOptions & options) {
 	d_nextAntCatalog = Time::Now();
 	d_nextFrameExport = d_nextAntCatalog.Add(10 * Duration::Second);
 
-	d_fullFrameExport = std::make_shared<artemis::FullFrameExportTask>(options.NewAntOutputDir);
+	d_fullFrameExport = std::make_shared<artemis::FullFrameExportTask>(options.NewAntOutputDir,
+	                                                                   d_budget);
 }
 
 
+void ProcessFrameTask::SetUpRecording(const RecordOptions & options,
+                                      const cv::Size & inputResolution) {
+	if ( options.OutputDir.empty() ) {
+		return;
+	}
+	d_recorder = std::make_shared<artemis::RawFrameRecorderTask>(options,inputResolution,d_lossLedger);
+}
+
 void ProcessFrameTask::SetUpConnection(const NetworkOptions & options,
 									   boost::asio::io_context & context) {
+	if ( options.ServePort != 0 ) {
+		d_server = ReadoutServer::Create(context,
+		                                 options.ServePort,
+		                                 options.ServeMaxSubscribers,
+		                                 options.ServeBacklog,
+		                                 options.MaxBatchSize);
+	}
 	if ( options.Host.empty() ) {
 		return;
 	}
-	d_connection = Connection::Create(context,options.Host,options.Port,5*Duration::Second);
+	ReadoutSpool::Ptr spool;
+	if ( options.SpoolPath.empty() == false ) {
+		spool = std::make_shared<ReadoutSpool>(options.SpoolPath,options.SpoolSize);
+	}
+	d_connection = Connection::Create(context,
+	                                  options.Host,
+	                                  options.Port,
+	                                  5*Duration::Second,
+	                                  d_lossLedger,
+	                                  options.MaxBatchSize,
+	                                  spool,
+	                                  options.SpoolReplayRate);
 }
 
 void ProcessFrameTask::SetUpUserInterface(const cv::Size & workingResolution,
                                           const cv::Size & fullResolution,
                                           const Options & options) {
+	if ( options.Display.Headless == true ) {
+		return;
+	}
 	d_userInterface = std::make_shared<artemis::UserInterfaceTask>(workingResolution,
 	                                                               fullResolution,
 	                                                               options);
@@ -110,12 +194,12 @@ void ProcessFrameTask::SetUpUserInterface(const cv::Size & workingResolution,
 }
 
 void ProcessFrameTask::SetUpPoolObjects() {
-	d_grayImagePool.Reserve(GrayscaleImagePerCycle() * ARTEMIS_FRAME_QUEUE_CAPACITY,
+	d_grayImagePool.Reserve(GrayscaleImagePerCycle() * (ARTEMIS_FRAME_QUEUE_CAPACITY + PIPELINE_DEPTH),
 	                        d_workingResolution.height,
 	                        d_workingResolution.width,
 	                        CV_8UC1);
 
-	d_rgbImagePool.Reserve(RGBImagePerCycle() * ARTEMIS_FRAME_QUEUE_CAPACITY,
+	d_rgbImagePool.Reserve(RGBImagePerCycle() * (ARTEMIS_FRAME_QUEUE_CAPACITY + PIPELINE_DEPTH),
 	                       d_workingResolution.height,
 	                       d_workingResolution.width,
 	                       CV_8UC3);
@@ -124,7 +208,50 @@ void ProcessFrameTask::SetUpPoolObjects() {
 
 ProcessFrameTask::~ProcessFrameTask() {}
 
+void ProcessFrameTask::RecordLatency(Duration latency) {
+	d_latencyTotal = d_latencyTotal + latency;
+	d_latencyMax = std::max(d_latencyMax,latency);
+}
+
+void ProcessFrameTask::EvaluateGroundTruth(const Frame::Ptr & frame,
+                                           const hermes::FrameReadout & m) {
+	// maximal distance to the ground truth for a tag to be detected.
+	const static double TOLERANCE = 3.0;
+	auto synthetic = dynamic_cast<const SyntheticFrame*>(frame.get());
+	if ( synthetic == nullptr ) {
+		return;
+	}
+	d_groundTruthTags += synthetic->Tags().size();
+	d_groundTruthDetected += synthetic->CountDetected(m,TOLERANCE);
+}
+
+void ProcessFrameTask::LogStatistics() {
+	auto elapsed = Time::Now().Sub(d_start);
+	LOG(INFO) << "[ProcessFrameTask]: processed " << d_frameProcessed
+	          << " frames in " << elapsed
+	          << " (" << double(d_frameProcessed) / elapsed.Seconds() << " FPS), dropped "
+	          << d_frameDropped;
+	LOG(INFO) << "[ProcessFrameTask]: frames lost by " << d_lossLedger->Summary();
+	if ( d_frameProcessed == 0 ) {
+		return;
+	}
+	LOG(INFO) << "[ProcessFrameTask]: acquisition to readout latency mean: "
+	          << Duration(d_latencyTotal.Nanoseconds() / int64_t(d_frameProcessed))
+	          << " max: " << d_latencyMax;
+	if ( d_groundTruthTags == 0 ) {
+		return;
+	}
+	LOG(INFO) << "[ProcessFrameTask]: detected " << d_groundTruthDetected
+	          << " of " << d_groundTruthTags << " synthetic tags (recall: "
+	          << 100.0 * double(d_groundTruthDetected) / double(d_groundTruthTags) << "%)";
+}
+
 void ProcessFrameTask::TearDown() {
+	if ( d_server ) {
+		// lets the IO context terminate.
+		ReadoutServer::Stop(d_server);
+	}
+
 	if ( d_userInterface ) {
 		d_userInterface->CloseQueue();
 	}
@@ -136,53 +263,133 @@ void ProcessFrameTask::TearDown() {
 	if ( d_videoOutput ) {
 		d_videoOutput->CloseQueue();
 	}
+
+	if ( d_recorder ) {
+		d_recorder->CloseQueue();
+	}
 }
 
 
 void ProcessFrameTask::Run() {
 	LOG(INFO) << "[ProcessFrameTask]: Started";
-	Frame::Ptr frame;
-	d_frameDropped = 0;
-	d_frameProcessed = 0;
 	d_start = Time::Now();
-	for (;;) {
-		d_frameQueue.pop(frame);
-		if ( !frame ) {
-			break;
-		}
 
-		if ( d_fullFrameExport && d_fullFrameExport->IsFree() ) {
-			d_actualThreads = d_maximumThreads;
-			cv::setNumThreads(d_actualThreads);
+	// The pipeline only runs while frames are queued: waiting for the
+	// next frame happens outside of the detection arena, so it never
+	// holds one of its threads.
+	Frame::Ptr next;
+	try {
+		while ( d_frameQueue.Pop(next) == true ) {
+			ProcessQueuedFrames(next);
+			PublishIdleDroppedFrames();
 		}
+	} catch ( ... ) {
+		// an acquisition blocked on a full queue must not wait for
+		// us.
+		d_frameQueue.Close();
+		throw;
+	}
+	PublishDroppedFrames(std::numeric_limits<uint64_t>::max());
 
-		ProcessFrameMandatory(frame);
+	LOG(INFO) << "[ProcessFrameTask]: Tear Down";
+	LogStatistics();
+	TearDown();
+	LOG(INFO) << "[ProcessFrameTask]: Ended";
+}
 
-		if ( d_frameQueue.size() > 0 ) {
-			if ( ShouldProcess(frame->ID()) == true ) {
-				DropFrame(frame);
-			}
-			continue;
+void ProcessFrameTask::ProcessQueuedFrames(Frame::Ptr & first) {
+	// While a frame is detected, the next one is already downscaled
+	// and the previous one is sent. All stages are serial and in
+	// order, so readouts leave in frame ID order. The whole pipeline
+	// runs within the detection arena shared by all cameras, and
+	// stops once the queue is empty.
+	d_budget->Detection().execute([this,&first]() {
+		tbb::parallel_pipeline(PIPELINE_DEPTH,
+		                       tbb::make_filter<void,FrameInFlightPtr>(SERIAL_IN_ORDER,
+		                                                               [this,&first](tbb::flow_control & fc) {
+			                                                               Frame::Ptr frame = std::move(first);
+			                                                               if ( !frame && d_frameQueue.TryPop(frame) == false ) {
+				                                                               fc.stop();
+				                                                               return FrameInFlightPtr();
+			                                                               }
+			                                                               return ReceiveFrame(frame);
+		                                                               })
+		                       & tbb::make_filter<FrameInFlightPtr,FrameInFlightPtr>(SERIAL_IN_ORDER,
+		                                                                             [this](FrameInFlightPtr item) {
+			                                                                             DetectFrame(*item);
+			                                                                             return item;
+		                                                                             })
+		                       & tbb::make_filter<FrameInFlightPtr,void>(SERIAL_IN_ORDER,
+		                                                                 [this](FrameInFlightPtr item) {
+			                                                                 PublishFrame(*item);
+		                                                                 }));
+	});
+}
+
+ProcessFrameTask::FrameInFlightPtr ProcessFrameTask::ReceiveFrame(const Frame::Ptr & frame) {
+	// frames already in the pipeline are not counted as backlog,
+	// they will be processed in time.
+	auto item = std::make_shared<FrameInFlight>();
+	item->Source = frame;
+	item->Dropped = d_options.QueuePolicy == ProcessOptions::FramePolicy::LatestWins
+		&& Backlog() > d_maximumBacklog;
+
+	ProcessFrameMandatory(*item);
+
+	if ( item->Dropped == false ) {
+		item->Message = PrepareMessage(Describe(*frame));
+	}
+	return item;
+}
+
+void ProcessFrameTask::DetectFrame(FrameInFlight & item) {
+	if ( item.Dropped == true
+	     || ShouldProcess(item.Source->ID()) == false ) {
+		return;
+	}
+	Detect(item.Source,*item.Message);
+}
+
+void ProcessFrameTask::PublishFrame(FrameInFlight & item) {
+	const auto & frame = item.Source;
+	PublishDroppedFrames(frame->ID());
+	if ( item.Dropped == true ) {
+		if ( ShouldProcess(frame->ID()) == true ) {
+			DropFrame(Describe(*frame),"stale frame in processing queue");
 		}
+		return;
+	}
 
-		ProcessFrame(frame);
+	if ( ShouldProcess(frame->ID()) == true ) {
+		PublishReadout(*item.Message,frame->ID());
+
+		CatalogAnt(frame,*item.Message);
+
+		ExportFullFrame(frame);
+
+		++d_frameProcessed;
+		RecordLatency(Time::Now().Sub(frame->Time()));
+		EvaluateGroundTruth(frame,*item.Message);
 	}
-	LOG(INFO) << "[ProcessFrameTask]: Tear Down";
-	TearDown();
-	LOG(INFO) << "[ProcessFrameTask]: Ended";
+
+	DisplayFrame(frame,item.Downscaled,item.Message);
 }
 
+size_t ProcessFrameTask::Backlog() const {
+	return d_frameQueue.Size();
+}
 
-void ProcessFrameTask::ProcessFrameMandatory(const Frame::Ptr & frame ) {
+void ProcessFrameTask::ProcessFrameMandatory(FrameInFlight & item) {
 	if ( !d_videoOutput && !d_userInterface ) {
 		return;
 	}
-	d_downscaled = d_grayImagePool.Get();
-	cv::resize(frame->ToCV(),*d_downscaled,d_workingResolution,0,0,cv::INTER_NEAREST);
+	const auto & frame = item.Source;
+	item.Downscaled = d_grayImagePool.Get();
+	cv::resize(frame->ToCV(),*item.Downscaled,d_workingResolution,0,0,cv::INTER_NEAREST);
 
 	if ( d_videoOutput ) {
 		auto converted = d_rgbImagePool.Get();
-		cv::cvtColor(*d_downscaled,*converted,cv::COLOR_GRAY2RGB);
+		cv::cvtColor(*item.Downscaled,*converted,cv::COLOR_GRAY2RGB);
 		d_videoOutput->QueueFrame(converted,frame->Time(),frame->ID());
 	}
 
@@ -190,54 +397,87 @@ void ProcessFrameTask::ProcessFrameMandatory(const Frame::Ptr & frame ) {
 
 }
 
-void ProcessFrameTask::DropFrame(const Frame::Ptr & frame) {
+void ProcessFrameTask::DropFrame(const FrameInfo & frame, const char * reason) {
 	++d_frameDropped;
+	d_lossLedger->Record(artemis::LossLedger::Stage::Processing,frame.ID,reason);
 	LOG(WARNING) << "Frame dropped due to over-processing. Total dropped: "
 	             << d_frameDropped
 	             << " ("
 	             << 100.0 * double(d_frameDropped) / double(d_frameDropped + d_frameProcessed)
 	             << "%)";
 
-	if ( !d_connection ) {
+	if ( !d_connection && !d_server ) {
 		return;
 	}
 
 	auto m = PrepareMessage(frame);
 	m->set_error(hermes::FrameReadout::PROCESS_OVERFLOW);
-
-	Connection::PostMessage(d_connection,*m);
+	PublishReadout(*m,frame.ID);
 }
 
-
-void ProcessFrameTask::ProcessFrame(const Frame::Ptr & frame) {
-	auto m = PrepareMessage(frame);
-
-	if ( ShouldProcess(frame->ID()) == true ) {
-		Detect(frame,*m);
-		if ( d_connection ) {
-			Connection::PostMessage(d_connection,*m);
+void ProcessFrameTask::PublishIdleDroppedFrames() {
+	for (;;) {
+		if ( d_hasNextDropped == false
+		     && d_droppedFrames.TryPop(d_nextDropped) == false ) {
+			return;
 		}
+		// a frame is only dropped once the queue is full, the frames
+		// that filled it come first.
+		if ( d_frameQueue.Size() != 0 ) {
+			d_hasNextDropped = true;
+			return;
+		}
+		d_hasNextDropped = false;
+		DropFrame(d_nextDropped,"processing queue is full");
+	}
+}
 
-		CatalogAnt(frame,*m);
-
-		ExportFullFrame(frame);
-
-		++d_frameProcessed;
+void ProcessFrameTask::PublishDroppedFrames(uint64_t beforeID) {
+	for (;;) {
+		if ( d_hasNextDropped == false
+		     && d_droppedFrames.TryPop(d_nextDropped) == false ) {
+			return;
+		}
+		if ( d_nextDropped.ID >= beforeID ) {
+			d_hasNextDropped = true;
+			return;
+		}
+		d_hasNextDropped = false;
+		DropFrame(d_nextDropped,"processing queue is full");
 	}
+}
 
-	DisplayFrame(frame,m);
+void ProcessFrameTask::PublishReadout(hermes::FrameReadout & m, uint64_t frameID) {
+	if ( !d_connection && !d_server ) {
+		return;
+	}
+	d_lossLedger->TagReadout(m);
+	if ( d_connection ) {
+		Connection::PostMessage(d_connection,m,frameID);
+	}
+	if ( d_server ) {
+		ReadoutServer::Publish(d_server,m,frameID);
+	}
 }
 
 
-std::shared_ptr<hermes::FrameReadout> ProcessFrameTask::PrepareMessage(const Frame::Ptr & frame) {
+ProcessFrameTask::FrameInfo ProcessFrameTask::Describe(const Frame & frame) {
+	return {.ID = frame.ID(),
+	        .Timestamp = frame.Timestamp(),
+	        .AcquisitionTime = frame.Time(),
+	        .Width = frame.Width(),
+	        .Height = frame.Height()};
+}
+
+std::shared_ptr<hermes::FrameReadout> ProcessFrameTask::PrepareMessage(const FrameInfo & frame) {
 	auto m = d_messagePool.Get();
 	m->Clear();
-	m->set_timestamp(frame->Timestamp());
-	m->set_frameid(frame->ID());
-	frame->Time().ToTimestamp(m->mutable_time());
+	m->set_timestamp(frame.Timestamp);
+	m->set_frameid(frame.ID);
+	frame.AcquisitionTime.ToTimestamp(m->mutable_time());
 	m->set_producer_uuid(d_options.UUID);
-	m->set_width(frame->Width());
-	m->set_height(frame->Height());
+	m->set_width(frame.Width);
+	m->set_height(frame.Height);
 	return m;
 }
 
@@ -252,18 +492,68 @@ bool ProcessFrameTask::ShouldProcess(uint64_t ID) {
 
 
 void ProcessFrameTask::QueueFrame( const Frame::Ptr & frame ) {
-	d_frameQueue.push(frame);
+	// the recorder wants every frame, even the ones we drop, and
+	// copies it out of the pipeline.
+	if ( d_recorder ) {
+		d_recorder->QueueFrame(frame);
+	}
+
+	auto toQueue = frame;
+	if ( d_options.QueuePolicy == ProcessOptions::FramePolicy::Blocking ) {
+		// waits for a free slot, unless processing already stopped.
+		if ( d_frameQueue.Push(toQueue) == false ) {
+			d_lossLedger->Record(artemis::LossLedger::Stage::Processing,frame->ID(),"processing stopped");
+		}
+		return;
+	}
+	if ( d_frameQueue.TryPush(toQueue) == true ) {
+		return;
+	}
+	// with the LatestWins policy, the pipeline drops stale frames
+	// as soon as it can, so the queue is only full when it is stuck
+	// on a single frame.
+	if ( ShouldProcess(frame->ID()) == false ) {
+		return;
+	}
+	// the drop is reported by the pipeline output stage, so its
+	// readout leaves in frame ID order.
+	auto dropped = Describe(*frame);
+	if ( d_droppedFrames.TryPush(dropped) == true ) {
+		return;
+	}
+	// the pipeline is stuck for long, the frame is only accounted for.
+	++d_frameDropped;
+	d_lossLedger->Record(artemis::LossLedger::Stage::Processing,frame->ID(),"processing queue is full");
 }
 
 void ProcessFrameTask::CloseFrameQueue() {
-	d_frameQueue.push({});
+	d_frameQueue.Close();
 }
 
 void ProcessFrameTask::Detect(const Frame::Ptr & frame,
                               hermes::FrameReadout & m) {
-	if ( d_detector ) {
-		d_detector->Detect(frame->ToCV(),d_actualThreads,m);
+	if ( !d_detector ) {
+		return;
 	}
+	auto start = Time::Now();
+	d_detector->Detect(frame->ToCV(),m);
+	AdaptDetectionQuality(Time::Now().Sub(start));
+}
+
+void ProcessFrameTask::AdaptDetectionQuality(Duration elapsed) {
+	if ( !d_qualityController ) {
+		return;
+	}
+	auto level = d_qualityController->Update(elapsed,Backlog() > 0);
+	size_t current = d_qualityLevel;
+	if ( level == current ) {
+		return;
+	}
+	LOG(INFO) << "[ProcessFrameTask]: detection took " << elapsed
+	          << ", switching from quality level " << current
+	          << " to " << level;
+	d_qualityLevel = level;
+	d_detector->SetQualityLevel(level);
 }
 
 void ProcessFrameTask::ExportFullFrame(const Frame::Ptr & frame) {
@@ -275,8 +565,6 @@ void ProcessFrameTask::ExportFullFrame(const Frame::Ptr & frame) {
 	if ( d_fullFrameExport->QueueExport(frame) == false ) {
 		return;
 	}
-	d_actualThreads = d_maximumThreads - 1;
-	cv::setNumThreads(d_actualThreads);
 	d_nextFrameExport = frame->Time().Add(d_options.ImageRenewPeriod);
 }
 
@@ -290,12 +578,14 @@ void ProcessFrameTask::CatalogAnt(const Frame::Ptr & frame,
 	ResetExportedID(frame->Time());
 
 	auto toExport = FindUnexportedID(m);
-	tbb::parallel_for(std::size_t(0),
-	                  toExport.size(),
-	                  [&] (std::size_t index) {
-		                  const auto & [tagID,x,y] = toExport[index];
-		                  ExportROI(frame->ToCV(),frame->ID(),tagID,x,y);
-	                  });
+	d_budget->Cataloguing().execute([&]() {
+		tbb::parallel_for(std::size_t(0),
+		                  toExport.size(),
+		                  [&] (std::size_t index) {
+			                  const auto & [tagID,x,y] = toExport[index];
+			                  ExportROI(frame->ToCV(),frame->ID(),tagID,x,y);
+		                  });
+	});
 	for ( const auto & [tagID,x,y] : toExport ) {
 		d_exportedID.insert(tagID);
 	}
@@ -316,7 +606,7 @@ ProcessFrameTask::FindUnexportedID(const hermes::FrameReadout & m) {
 			continue;
 		}
 		res.push_back({t.id(),t.x(),t.y()});
-		if ( res.size() >= d_actualThreads ) {
+		if ( res.size() >= size_t(d_budget->Cataloguing().max_concurrency()) ) {
 			break;
 		}
 	}
@@ -343,7 +633,11 @@ void ProcessFrameTask::ExportROI(const cv::Mat & image,
 
 
 void ProcessFrameTask::DisplayFrame(const Frame::Ptr frame,
+                                    const std::shared_ptr<cv::Mat> & downscaled,
                                     const std::shared_ptr<hermes::FrameReadout> & m) {
+	if ( !d_userInterface ) {
+		return;
+	}
 
 	d_wantedROI = d_userInterface->UpdateROI(d_wantedROI);
 
@@ -358,7 +652,7 @@ void ProcessFrameTask::DisplayFrame(const Frame::Ptr frame,
 	}
 
 	UserInterface::FrameToDisplay toDisplay =
-		{.Full = d_downscaled,
+		{.Full = downscaled,
 		 .Zoomed = zoomed,
 		 .Message = m,
 		 .CurrentROI = d_wantedROI,
@@ -368,6 +662,7 @@ void ProcessFrameTask::DisplayFrame(const Frame::Ptr frame,
 		 .FrameDropped = d_frameDropped,
 		 .VideoOutputProcessed = -1UL,
 		 .VideoOutputDropped = -1UL,
+		 .QualityLevel = d_qualityLevel,
 		};
 
 	if ( d_videoOutput != nullptr ) {
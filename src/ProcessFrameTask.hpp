@@ -1,6 +1,6 @@
 #pragma once
 
-#include <tbb/concurrent_queue.h>
+#include <atomic>
 
 #include <opencv2/core.hpp>
 
@@ -12,6 +12,8 @@
 #include "Options.hpp"
 #include "FrameGrabber.hpp"
 #include "ObjectPool.hpp"
+#include "SPSCRing.hpp"
+#include "ThreadBudget.hpp"
 
 #include "ui/UserInterface.hpp"
 
@@ -29,16 +31,25 @@ class UserInterfaceTask;
 typedef std::shared_ptr<UserInterfaceTask>   UserInterfaceTaskPtr;
 class Connection;
 typedef std::shared_ptr<Connection>          ConnectionPtr;
+class ReadoutServer;
+typedef std::shared_ptr<ReadoutServer>       ReadoutServerPtr;
 class FullFrameExportTask;
 typedef std::shared_ptr<FullFrameExportTask> FullFrameExportTaskPtr;
+class RawFrameRecorderTask;
+typedef std::shared_ptr<RawFrameRecorderTask> RawFrameRecorderTaskPtr;
 class ApriltagDetector;
 typedef std::shared_ptr<ApriltagDetector>    ApriltagDetectorPtr;
+class QualityController;
+typedef std::unique_ptr<QualityController>   QualityControllerPtr;
+class LossLedger;
+typedef std::shared_ptr<LossLedger>          LossLedgerPtr;
 
 class ProcessFrameTask : public Task{
 public:
 	ProcessFrameTask(const Options & options,
 	                 boost::asio::io_context & context,
-	                 const cv::Size & inputResolution);
+	                 const cv::Size & inputResolution,
+	                 const ThreadBudget::Ptr & budget);
 
 	virtual ~ProcessFrameTask();
 
@@ -50,17 +61,51 @@ public:
 	VideoOutputTaskPtr     VideoOutputTask() const;
 	UserInterfaceTaskPtr   UserInterfaceTask() const;
 	FullFrameExportTaskPtr FullFrameExportTask() const;
+	RawFrameRecorderTaskPtr RawFrameRecorderTask() const;
+	LossLedgerPtr          LossLedger() const;
 
 
 private :
-	typedef tbb::concurrent_bounded_queue<Frame::Ptr> FrameQueue;
+	// frames are handed over by the single acquisition thread to
+	// the pipeline input stage.
+	typedef SPSCRing<Frame::Ptr> FrameQueue;
+
+	// A frame travelling through the processing pipeline, with the
+	// data produced by each stage.
+	struct FrameInFlight {
+		Frame::Ptr                            Source;
+		std::shared_ptr<cv::Mat>              Downscaled;
+		std::shared_ptr<hermes::FrameReadout> Message;
+		bool                                  Dropped = false;
+	};
+	typedef std::shared_ptr<FrameInFlight> FrameInFlightPtr;
+
+	// What a readout needs from a frame, without holding on to its
+	// buffer.
+	struct FrameInfo {
+		uint64_t ID = 0;
+		uint64_t Timestamp = 0;
+		Time     AcquisitionTime;
+		size_t   Width = 0;
+		size_t   Height = 0;
+	};
+
+	// Frames dropped by the acquisition thread that wait for their
+	// readout to be sent by the pipeline output stage.
+	const static size_t MAX_PENDING_DROPS = 64;
+
+	// Number of frames processed concurrently by the pipeline, one
+	// per stage.
+	const static size_t PIPELINE_DEPTH = 3;
 
 	void SetUpVideoOutputTask(const VideoOutputOptions & options,
 	                          boost::asio::io_context & context,
 	                          bool legacyMode);
 	void SetUpDetection(const cv::Size & inputResolution,
-	                    const ApriltagOptions & options);
+	                    const Options & options);
 	void SetUpCataloguing(const ProcessOptions & options);
+	void SetUpRecording(const RecordOptions & options,
+	                    const cv::Size & inputResolution);
 	void SetUpUserInterface(const cv::Size & workingresolution,
 	                        const cv::Size & fullresolution,
 	                        const Options & options);
@@ -69,14 +114,33 @@ private :
 	void SetUpConnection(const NetworkOptions & options, boost::asio::io_context & context);
 
 
-	void ProcessFrameMandatory(const Frame::Ptr & frame );
-	void ProcessFrame(const Frame::Ptr & frame);
-	void DropFrame(const Frame::Ptr & frame);
+	// Runs the pipeline on first and the frames queued after it,
+	// until the queue is empty.
+	void ProcessQueuedFrames(Frame::Ptr & first);
+	// Pipeline stages, each one sees the frames in their ID order.
+	FrameInFlightPtr ReceiveFrame(const Frame::Ptr & frame);
+	void DetectFrame(FrameInFlight & item);
+	void PublishFrame(FrameInFlight & item);
+
+	void ProcessFrameMandatory(FrameInFlight & item);
+	void DropFrame(const FrameInfo & frame, const char * reason);
+	// Sends the readouts of the frames dropped by the acquisition
+	// thread before frame beforeID, in order.
+	void PublishDroppedFrames(uint64_t beforeID);
+	// Sends the readouts of the dropped frames while the pipeline is
+	// idle, once no frame before them is left in the queue.
+	void PublishIdleDroppedFrames();
+	// Sends the readout to the connection and the subscribers, if any.
+	void PublishReadout(hermes::FrameReadout & m, uint64_t frameID);
+
+	size_t Backlog() const;
 
 
 	void Detect(const Frame::Ptr & frame,
 	            hermes::FrameReadout & m);
 
+	void AdaptDetectionQuality(Duration elapsed);
+
 	void ResetExportedID(const Time & time);
 
 	std::vector<std::tuple<uint32_t,double,double>> FindUnexportedID(const hermes::FrameReadout & m);
@@ -93,14 +157,22 @@ private :
 	void ExportFullFrame(const Frame::Ptr & frame);
 
 	void DisplayFrame(const Frame::Ptr frame,
+	                  const std::shared_ptr<cv::Mat> & downscaled,
 	                  const std::shared_ptr<hermes::FrameReadout> & m);
 
+	void RecordLatency(Duration latency);
+	void EvaluateGroundTruth(const Frame::Ptr & frame,
+	                         const hermes::FrameReadout & m);
+	void LogStatistics();
+
 	void TearDown();
 
 	size_t GrayscaleImagePerCycle() const;
 	size_t RGBImagePerCycle() const;
 
-	std::shared_ptr<hermes::FrameReadout> PrepareMessage(const Frame::Ptr & frame);
+	static FrameInfo Describe(const Frame & frame);
+
+	std::shared_ptr<hermes::FrameReadout> PrepareMessage(const FrameInfo & frame);
 
 	bool ShouldProcess(uint64_t ID);
 
@@ -108,24 +180,36 @@ private :
 
 	const ProcessOptions   d_options;
 
+	LossLedgerPtr          d_lossLedger;
 	FrameQueue             d_frameQueue;
+	SPSCRing<FrameInfo>    d_droppedFrames;
+	// output stage only: the first dropped frame that comes after the
+	// frame being published.
+	FrameInfo              d_nextDropped;
+	bool                   d_hasNextDropped;
 	VideoOutputTaskPtr     d_videoOutput;
 	UserInterfaceTaskPtr   d_userInterface;
 
 	ConnectionPtr          d_connection;
+	ReadoutServerPtr       d_server;
 
 	FullFrameExportTaskPtr d_fullFrameExport;
 
+	RawFrameRecorderTaskPtr d_recorder;
+
 
 	ObjectPool<cv::Mat>               d_grayImagePool;
 	ObjectPool<cv::Mat>               d_rgbImagePool;
 
 	ObjectPool<hermes::FrameReadout>  d_messagePool;
-	std::shared_ptr<cv::Mat>          d_downscaled;
-	const size_t                      d_maximumThreads;
-	size_t                            d_actualThreads;
+	ThreadBudget::Ptr                 d_budget;
 
 	ApriltagDetectorPtr               d_detector;
+	QualityControllerPtr              d_qualityController;
+	std::atomic<size_t>               d_qualityLevel;
+	// number of frames allowed to wait in the queue before we drop
+	// them, with the LatestWins policy.
+	size_t                            d_maximumBacklog;
 
 	Time                              d_nextFrameExport;
 	Time                              d_nextAntCatalog;
@@ -133,9 +217,17 @@ private :
 
 	cv::Size            d_workingResolution;
 	cv::Rect            d_wantedROI;
-	size_t              d_frameDropped;
-	size_t              d_frameProcessed;
+	// frames may be dropped by the acquisition thread when the queue
+	// is full.
+	std::atomic<size_t> d_frameDropped;
+	std::atomic<size_t> d_frameProcessed;
 	Time                d_start;
+	// latency between a frame acquisition and its readout.
+	Duration            d_latencyTotal;
+	Duration            d_latencyMax;
+	// detection recall on synthetic frames.
+	size_t              d_groundTruthTags;
+	size_t              d_groundTruthDetected;
 };
 
 } // namespace artemis
@@ -0,0 +1,61 @@
+#include "QualityController.hpp"
+
+namespace fort {
+namespace artemis {
+
+// weight of a new measurement in the moving average
+const static double SMOOTHING = 0.3;
+// fractions of the budget to go down and up in quality
+const static double LOW_WATERMARK = 0.6;
+const static double HIGH_WATERMARK = 0.9;
+
+QualityController::QualityController(Duration budget, size_t levels)
+	: d_budget(budget.Seconds())
+	, d_maxLevel(levels > 0 ? levels - 1 : 0)
+	, d_level(0)
+	, d_average(-1.0)
+	, d_cooldown(0)
+	, d_stable(0) {
+}
+
+size_t QualityController::Update(Duration elapsed, bool backlog) {
+	if ( d_average < 0.0 ) {
+		d_average = elapsed.Seconds();
+	} else {
+		d_average = (1.0 - SMOOTHING) * d_average + SMOOTHING * elapsed.Seconds();
+	}
+
+	// lets the average settle after a change of level.
+	if ( d_cooldown > 0 ) {
+		--d_cooldown;
+		return d_level;
+	}
+
+	if ( backlog == true || d_average > HIGH_WATERMARK * d_budget ) {
+		d_stable = 0;
+		if ( d_level < d_maxLevel ) {
+			++d_level;
+			d_cooldown = COOLDOWN_FRAMES;
+		}
+		return d_level;
+	}
+
+	if ( d_level == 0 || d_average >= LOW_WATERMARK * d_budget ) {
+		d_stable = 0;
+		return d_level;
+	}
+
+	if ( ++d_stable >= STABLE_FRAMES ) {
+		--d_level;
+		d_stable = 0;
+		d_cooldown = COOLDOWN_FRAMES;
+	}
+	return d_level;
+}
+
+size_t QualityController::Level() const {
+	return d_level;
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Time.hpp"
+
+namespace fort {
+namespace artemis {
+
+// Chooses a detection quality level so that detection fits in a
+// per-frame time budget. Level 0 is the best quality, and higher
+// levels are cheaper. The level is raised as soon as the average
+// detection time gets close to the budget, or frames start to queue
+// up, and only lowered after a stable period with enough spare time.
+class QualityController {
+public:
+	QualityController(Duration budget, size_t levels);
+
+	size_t Update(Duration elapsed, bool backlog);
+
+	size_t Level() const;
+
+	const static size_t COOLDOWN_FRAMES = 5;
+	const static size_t STABLE_FRAMES = 25;
+
+private:
+	const double d_budget;
+	const size_t d_maxLevel;
+
+	size_t d_level;
+	double d_average;
+	size_t d_cooldown;
+	size_t d_stable;
+};
+
+} // namespace artemis
+} // namespace fort
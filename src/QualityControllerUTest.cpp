@@ -0,0 +1,49 @@
+#include "QualityControllerUTest.hpp"
+
+#include "QualityController.hpp"
+
+namespace fort {
+namespace artemis {
+
+TEST_F(QualityControllerUTest,StaysWithinLevels) {
+	QualityController controller(100 * Duration::Millisecond,3);
+	EXPECT_EQ(controller.Level(),0);
+
+	for ( size_t i = 0; i < 10 * QualityController::COOLDOWN_FRAMES; ++i ) {
+		controller.Update(150 * Duration::Millisecond,false);
+	}
+	EXPECT_EQ(controller.Level(),2);
+
+	for ( size_t i = 0; i < 10 * QualityController::STABLE_FRAMES; ++i ) {
+		controller.Update(10 * Duration::Millisecond,false);
+	}
+	EXPECT_EQ(controller.Level(),0);
+}
+
+TEST_F(QualityControllerUTest,ReactsToBacklog) {
+	QualityController controller(100 * Duration::Millisecond,4);
+	EXPECT_EQ(controller.Update(10 * Duration::Millisecond,true),1);
+	// waits for the new level to settle
+	for ( size_t i = 0; i < QualityController::COOLDOWN_FRAMES; ++i ) {
+		EXPECT_EQ(controller.Update(10 * Duration::Millisecond,true),1);
+	}
+	EXPECT_EQ(controller.Update(10 * Duration::Millisecond,true),2);
+}
+
+TEST_F(QualityControllerUTest,HasHysteresis) {
+	QualityController controller(100 * Duration::Millisecond,4);
+	controller.Update(95 * Duration::Millisecond,false);
+	EXPECT_EQ(controller.Level(),1);
+	// in between watermarks, nothing changes
+	for ( size_t i = 0; i < 2 * QualityController::STABLE_FRAMES; ++i ) {
+		EXPECT_EQ(controller.Update(75 * Duration::Millisecond,false),1);
+	}
+	// needs a stable period to go back to full quality
+	for ( size_t i = 0; i < QualityController::STABLE_FRAMES - 1; ++i ) {
+		EXPECT_EQ(controller.Update(20 * Duration::Millisecond,false),1);
+	}
+	EXPECT_EQ(controller.Update(20 * Duration::Millisecond,false),0);
+}
+
+} // namespace artemis
+} // namespace fort
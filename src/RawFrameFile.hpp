@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace fort {
+namespace artemis {
+
+// Layout of raw frame recordings. A file starts with a HEADER_SIZE
+// bytes header, followed by fixed size slots. Each slot holds a
+// SlotHeader at its start and the 8-bit grayscale pixels at
+// DATA_OFFSET, rows packed without padding. Sizes are multiples of
+// ALIGNMENT so the slots can be written with direct I/O and mapped
+// in memory as they are.
+//
+// A slot whose marker is not SLOT_MARKER marks the end of the
+// recording, as files may be pre-allocated with zeroes.
+//
+// A recording directory holds consecutive segment files named by
+// SegmentPath().
+struct RawFrameFile {
+	const static size_t   ALIGNMENT   = 4096;
+	const static size_t   HEADER_SIZE = ALIGNMENT;
+	const static size_t   DATA_OFFSET = 64;
+	// "ARTRAW01" read as a little endian integer.
+	const static uint64_t MAGIC       = 0x3130574152545241ULL;
+	const static uint32_t VERSION     = 1;
+	// "FRAM" read as a little endian integer.
+	const static uint32_t SLOT_MARKER = 0x4d415246;
+
+	struct Header {
+		uint64_t Magic;
+		uint32_t Version;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Reserved;
+		uint64_t SlotSize;
+	};
+
+	struct SlotHeader {
+		uint32_t Marker;
+		uint32_t Reserved;
+		uint64_t FrameID;
+		// camera timestamp in microseconds, as Frame::Timestamp().
+		uint64_t Timestamp;
+	};
+
+	static_assert(sizeof(Header) <= HEADER_SIZE,"Header does not fit");
+	static_assert(sizeof(SlotHeader) <= DATA_OFFSET,"SlotHeader does not fit");
+
+	static size_t SlotSize(size_t width, size_t height) {
+		size_t size = DATA_OFFSET + width * height;
+		return ((size + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+	}
+
+	static Header MakeHeader(size_t width, size_t height) {
+		return {.Magic = MAGIC,
+		        .Version = VERSION,
+		        .Width = uint32_t(width),
+		        .Height = uint32_t(height),
+		        .Reserved = 0,
+		        .SlotSize = SlotSize(width,height),
+		};
+	}
+
+	static std::string SegmentPath(const std::string & dir, size_t index) {
+		std::ostringstream oss;
+		oss << dir << "/frames." << std::setw(4) << std::setfill('0') << index << ".raw";
+		return oss.str();
+	}
+
+	static void Validate(const Header & header, const std::string & path) {
+		if ( header.Magic != MAGIC ) {
+			throw std::runtime_error("'" + path + "' is not a raw frame recording");
+		}
+		if ( header.Version != VERSION ) {
+			throw std::runtime_error("'" + path + "' has unsupported version "
+			                         + std::to_string(header.Version));
+		}
+		if ( header.SlotSize != SlotSize(header.Width,header.Height) ) {
+			throw std::runtime_error("'" + path + "' has an invalid slot size");
+		}
+	}
+};
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,216 @@
+#include "RawFrameGrabber.hpp"
+
+#include "utils/PosixCall.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include <glog/logging.h>
+
+namespace fort {
+namespace artemis {
+
+RawFrame::RawFrame(const std::shared_ptr<const RawFrameGrabber> & grabber,
+                   const RawFrameFile::SlotHeader * slot,
+                   size_t width,
+                   size_t height)
+	: d_grabber(grabber)
+	, d_slot(slot)
+	// the mapping is read-only, and nobody writes to frame data.
+	, d_mat(height,width,CV_8UC1,
+	        const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(slot) + RawFrameFile::DATA_OFFSET)) {
+}
+
+RawFrame::~RawFrame() {}
+
+void * RawFrame::Data() {
+	return d_mat.data;
+}
+
+size_t RawFrame::Width() const {
+	return d_mat.cols;
+}
+
+size_t RawFrame::Height() const {
+	return d_mat.rows;
+}
+
+uint64_t RawFrame::Timestamp() const {
+	return d_slot->Timestamp;
+}
+
+uint64_t RawFrame::ID() const {
+	return d_slot->FrameID;
+}
+
+const cv::Mat & RawFrame::ToCV() {
+	return d_mat;
+}
+
+
+RawFrameGrabber::RawFrameGrabber(const std::string & path, bool realTime)
+	: d_path(path)
+	, d_realTime(realTime)
+	, d_size(0)
+	, d_segment(0)
+	, d_next(0)
+	, d_firstTimestamp(0) {
+	struct stat info;
+	if ( stat(path.c_str(),&info) < 0 ) {
+		throw std::system_error(errno,ARTEMIS_SYSTEM_CATEGORY(),"stat('" + path + "')");
+	}
+
+	try {
+		if ( S_ISDIR(info.st_mode) ) {
+			// segments are numbered from zero, without gaps.
+			for ( size_t i = 0; ; ++i ) {
+				auto segment = RawFrameFile::SegmentPath(path,i);
+				if ( access(segment.c_str(),F_OK) != 0 ) {
+					break;
+				}
+				MapSegment(segment);
+			}
+		} else {
+			MapSegment(path);
+		}
+		if ( d_size == 0 ) {
+			throw std::runtime_error("'" + path + "' does not contain any frame");
+		}
+	} catch ( const std::exception & ) {
+		UnmapSegments();
+		throw;
+	}
+	d_firstTimestamp = Slot(d_segments.front(),0)->Timestamp;
+
+	LOG(INFO) << "[RawFrameGrabber]: replaying " << d_size << " frames of "
+	          << d_header.Width << "x" << d_header.Height
+	          << " from " << d_segments.size() << " segment(s) in '" << path << "'"
+	          << (d_realTime ? " in real-time" : " as fast as possible");
+}
+
+RawFrameGrabber::~RawFrameGrabber() {
+	UnmapSegments();
+}
+
+void RawFrameGrabber::UnmapSegments() {
+	for ( const auto & segment : d_segments ) {
+		munmap(const_cast<uint8_t*>(segment.Mapped),segment.MappedSize);
+	}
+	d_segments.clear();
+}
+
+void RawFrameGrabber::MapSegment(const std::string & path) {
+	int fd = open(path.c_str(),O_RDONLY);
+	if ( fd < 0 ) {
+		throw std::system_error(errno,ARTEMIS_SYSTEM_CATEGORY(),"open('" + path + "')");
+	}
+	struct stat info;
+	if ( fstat(fd,&info) < 0 ) {
+		int err = errno;
+		close(fd);
+		throw ARTEMIS_SYSTEM_ERROR(fstat,err);
+	}
+	if ( size_t(info.st_size) < RawFrameFile::HEADER_SIZE ) {
+		close(fd);
+		throw std::runtime_error("'" + path + "' is too small to be a raw frame recording");
+	}
+
+	size_t mappedSize = info.st_size;
+	auto mapped = mmap(nullptr,mappedSize,PROT_READ,MAP_SHARED,fd,0);
+	// the mapping stays valid once the file is closed.
+	close(fd);
+	if ( mapped == MAP_FAILED ) {
+		throw ARTEMIS_SYSTEM_ERROR(mmap,errno);
+	}
+	// frames are read once, in order.
+	madvise(mapped,mappedSize,MADV_SEQUENTIAL);
+	Segment segment = {.Mapped = reinterpret_cast<const uint8_t*>(mapped),
+	                   .MappedSize = mappedSize,
+	                   .Size = 0};
+
+	RawFrameFile::Header header;
+	try {
+		std::memcpy(&header,segment.Mapped,sizeof(header));
+		RawFrameFile::Validate(header,path);
+		if ( d_segments.empty() == false
+		     && ( header.Width != d_header.Width || header.Height != d_header.Height ) ) {
+			throw std::runtime_error("'" + path + "' resolution differs from the previous segments");
+		}
+	} catch ( const std::exception & ) {
+		munmap(mapped,mappedSize);
+		throw;
+	}
+	d_header = header;
+
+	// the segment ends with the last complete and marked slot.
+	size_t slots = (mappedSize - RawFrameFile::HEADER_SIZE) / d_header.SlotSize;
+	while( segment.Size < slots && Slot(segment,segment.Size)->Marker == RawFrameFile::SLOT_MARKER ) {
+		++segment.Size;
+	}
+	if ( segment.Size == 0 ) {
+		munmap(mapped,mappedSize);
+		return;
+	}
+	d_size += segment.Size;
+	d_segments.push_back(segment);
+}
+
+void RawFrameGrabber::Start() {
+	d_segment = 0;
+	d_next = 0;
+	d_start = Time::Now();
+}
+
+void RawFrameGrabber::Stop() {
+}
+
+cv::Size RawFrameGrabber::Resolution() const {
+	return cv::Size(d_header.Width,d_header.Height);
+}
+
+bool RawFrameGrabber::ContiguousFrameIDs() const {
+	return false;
+}
+
+size_t RawFrameGrabber::Size() const {
+	return d_size;
+}
+
+const RawFrameFile::SlotHeader * RawFrameGrabber::Slot(const Segment & segment,
+                                                       size_t index) const {
+	return reinterpret_cast<const RawFrameFile::SlotHeader*>(segment.Mapped
+	                                                        + RawFrameFile::HEADER_SIZE
+	                                                        + index * d_header.SlotSize);
+}
+
+Frame::Ptr RawFrameGrabber::NextFrame() {
+	while ( d_segment < d_segments.size() && d_next >= d_segments[d_segment].Size ) {
+		++d_segment;
+		d_next = 0;
+	}
+	if ( d_segment >= d_segments.size() ) {
+		return Frame::Ptr();
+	}
+	auto slot = Slot(d_segments[d_segment],d_next++);
+
+	if ( d_realTime == true ) {
+		Duration elapsed = int64_t(1000) * int64_t(slot->Timestamp - d_firstTimestamp);
+		auto toWait = d_start.Add(elapsed).Sub(Time::Now());
+		if ( toWait > 0 ) {
+			usleep(toWait.Microseconds());
+		}
+	}
+
+	return std::make_shared<RawFrame>(shared_from_this(),
+	                                  slot,
+	                                  d_header.Width,
+	                                  d_header.Height);
+}
+
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "FrameGrabber.hpp"
+#include "RawFrameFile.hpp"
+
+#include <vector>
+
+namespace fort {
+namespace artemis {
+
+class RawFrameGrabber;
+
+class RawFrame : public Frame {
+public :
+	// the frame keeps the recording mapped as long as it is alive.
+	RawFrame(const std::shared_ptr<const RawFrameGrabber> & grabber,
+	         const RawFrameFile::SlotHeader * slot,
+	         size_t width,
+	         size_t height);
+	virtual ~RawFrame();
+
+	virtual void * Data();
+	virtual size_t Width() const;
+	virtual size_t Height() const;
+	virtual uint64_t Timestamp() const;
+	virtual uint64_t ID() const;
+	const cv::Mat & ToCV();
+private :
+	std::shared_ptr<const RawFrameGrabber> d_grabber;
+	const RawFrameFile::SlotHeader *       d_slot;
+	cv::Mat                                d_mat;
+};
+
+// Replays a raw frame recording, mapped in memory. Frames keep their
+// recorded ID and timestamp. In real-time mode frames are delivered
+// at their recorded pace, otherwise as fast as they are requested.
+// NextFrame() returns an empty pointer once the recording is over.
+class RawFrameGrabber : public FrameGrabber,
+                        public std::enable_shared_from_this<RawFrameGrabber> {
+public :
+	// path is either a single segment file, or a recording directory
+	// whose segments are all replayed in order.
+	RawFrameGrabber(const std::string & path, bool realTime);
+
+	virtual ~RawFrameGrabber();
+
+	void Start() override;
+	void Stop() override;
+	Frame::Ptr NextFrame() override;
+
+	cv::Size Resolution() const override;
+
+	// recordings may be strided, and their own losses were accounted
+	// for while recording.
+	bool ContiguousFrameIDs() const override;
+
+	size_t Size() const;
+private:
+	struct Segment {
+		const uint8_t * Mapped;
+		size_t          MappedSize;
+		// number of recorded frames.
+		size_t          Size;
+	};
+
+	// Maps a segment, skipping it if it holds no frame.
+	void MapSegment(const std::string & path);
+	void UnmapSegments();
+	const RawFrameFile::SlotHeader * Slot(const Segment & segment, size_t index) const;
+
+	std::string                 d_path;
+	const bool                  d_realTime;
+	std::vector<Segment>        d_segments;
+	RawFrameFile::Header        d_header;
+	size_t                      d_size;
+	size_t                      d_segment,d_next;
+	Time                        d_start;
+	uint64_t                    d_firstTimestamp;
+};
+
+
+} // namespace artemis
+} // namespace fort
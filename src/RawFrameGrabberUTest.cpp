@@ -0,0 +1,166 @@
+#include "RawFrameGrabberUTest.hpp"
+
+#include "RawFrameGrabber.hpp"
+#include "RawFrameRecorderTask.hpp"
+#include "StubFrameGrabber.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fort {
+namespace artemis {
+
+const static size_t WIDTH = 32;
+const static size_t HEIGHT = 16;
+
+void RawFrameGrabberUTest::SetUp() {
+	d_path = ::testing::TempDir() + "/artemis-raw-" + std::to_string(getpid()) + ".raw";
+
+	auto header = RawFrameFile::MakeHeader(WIDTH,HEIGHT);
+	std::vector<char> buffer(RawFrameFile::HEADER_SIZE + 3 * header.SlotSize,0);
+	std::memcpy(buffer.data(),&header,sizeof(header));
+	for ( size_t i = 0; i < 2; ++i ) {
+		auto slot = buffer.data() + RawFrameFile::HEADER_SIZE + i * header.SlotSize;
+		RawFrameFile::SlotHeader slotHeader = {.Marker = RawFrameFile::SLOT_MARKER,
+		                                       .Reserved = 0,
+		                                       .FrameID = 42 + 2 * i,
+		                                       .Timestamp = 1000 + 125000 * i };
+		std::memcpy(slot,&slotHeader,sizeof(slotHeader));
+		std::memset(slot + RawFrameFile::DATA_OFFSET,10 * (i+1),WIDTH * HEIGHT);
+	}
+	// the last slot is left blank, as pre-allocated by a recorder.
+
+	std::ofstream file(d_path,std::ios::binary);
+	file.write(buffer.data(),buffer.size());
+}
+
+void RawFrameGrabberUTest::TearDown() {
+	unlink(d_path.c_str());
+}
+
+TEST_F(RawFrameGrabberUTest,ReplaysRecordedFrames) {
+	auto grabber = std::make_shared<RawFrameGrabber>(d_path,false);
+	EXPECT_EQ(grabber->Size(),2);
+	EXPECT_EQ(grabber->Resolution(),cv::Size(WIDTH,HEIGHT));
+
+	grabber->Start();
+	for ( size_t i = 0; i < 2; ++i ) {
+		auto frame = grabber->NextFrame();
+		ASSERT_TRUE(frame);
+		EXPECT_EQ(frame->ID(),42 + 2 * i);
+		EXPECT_EQ(frame->Timestamp(),1000 + 125000 * i);
+		EXPECT_EQ(frame->Width(),WIDTH);
+		EXPECT_EQ(frame->Height(),HEIGHT);
+		EXPECT_EQ(frame->ToCV().at<uint8_t>(HEIGHT-1,WIDTH-1),10 * (i+1));
+	}
+	EXPECT_FALSE(grabber->NextFrame());
+}
+
+TEST_F(RawFrameGrabberUTest,FramesKeepRecordingMapped) {
+	Frame::Ptr frame;
+	{
+		auto grabber = std::make_shared<RawFrameGrabber>(d_path,false);
+		grabber->Start();
+		frame = grabber->NextFrame();
+	}
+	EXPECT_EQ(frame->ToCV().at<uint8_t>(0,0),10);
+}
+
+TEST_F(RawFrameGrabberUTest,ReplaysInRealTime) {
+	auto grabber = std::make_shared<RawFrameGrabber>(d_path,true);
+	grabber->Start();
+	auto first = grabber->NextFrame();
+	auto second = grabber->NextFrame();
+	EXPECT_TRUE(second->Time().Sub(first->Time()) >= 100 * Duration::Millisecond);
+}
+
+TEST_F(RawFrameGrabberUTest,RejectsInvalidFiles) {
+	{
+		std::ofstream file(d_path,std::ios::binary | std::ios::trunc);
+		std::vector<char> zeroes(2 * RawFrameFile::HEADER_SIZE,0);
+		file.write(zeroes.data(),zeroes.size());
+	}
+	EXPECT_THROW(std::make_shared<RawFrameGrabber>(d_path,false),std::runtime_error);
+	EXPECT_THROW(std::make_shared<RawFrameGrabber>(d_path + ".missing",false),std::system_error);
+}
+
+TEST_F(RawFrameGrabberUTest,ReplaysRecordingDirectory) {
+	auto dir = ::testing::TempDir() + "/artemis-recording-" + std::to_string(getpid());
+	ASSERT_EQ(mkdir(dir.c_str(),0755),0);
+
+	RecordOptions options;
+	options.OutputDir = dir;
+	options.Stride = 1;
+	options.SegmentFrames = 2;
+	options.QueueSize = 8;
+	{
+		RawFrameRecorderTask recorder(options,cv::Size(WIDTH,HEIGHT));
+		std::thread writer([&recorder]() { recorder.Run(); });
+		for ( uint64_t i = 0; i < 3; ++i ) {
+			auto frame = std::make_shared<StubFrame>();
+			frame->Reset(cv::Mat(HEIGHT,WIDTH,CV_8UC1,cv::Scalar(10 * (i+1))),i);
+			EXPECT_TRUE(recorder.QueueFrame(frame));
+		}
+		recorder.CloseQueue();
+		writer.join();
+		EXPECT_EQ(recorder.FrameRecorded(),3);
+	}
+
+	{
+		// the third frame is in the second segment.
+		auto grabber = std::make_shared<RawFrameGrabber>(dir,false);
+		EXPECT_EQ(grabber->Size(),3);
+		EXPECT_EQ(grabber->Resolution(),cv::Size(WIDTH,HEIGHT));
+		grabber->Start();
+		for ( uint64_t i = 0; i < 3; ++i ) {
+			auto frame = grabber->NextFrame();
+			ASSERT_TRUE(frame);
+			EXPECT_EQ(frame->ID(),i);
+			EXPECT_EQ(frame->ToCV().at<uint8_t>(HEIGHT-1,WIDTH-1),10 * (i+1));
+		}
+		EXPECT_FALSE(grabber->NextFrame());
+	}
+
+	for ( size_t i = 0; i < 2; ++i ) {
+		EXPECT_EQ(unlink(RawFrameFile::SegmentPath(dir,i).c_str()),0);
+	}
+	unlink((dir + "/frames.index").c_str());
+	rmdir(dir.c_str());
+}
+
+TEST_F(RawFrameGrabberUTest,RecorderAccountsForDrops) {
+	auto dir = ::testing::TempDir() + "/artemis-recording-drops-" + std::to_string(getpid());
+	ASSERT_EQ(mkdir(dir.c_str(),0755),0);
+
+	RecordOptions options;
+	options.OutputDir = dir;
+	options.Stride = 1;
+	options.QueueSize = 1;
+	auto ledger = std::make_shared<LossLedger>();
+	{
+		// nothing is written, the second frame finds no free buffer.
+		RawFrameRecorderTask recorder(options,cv::Size(WIDTH,HEIGHT),ledger);
+		for ( uint64_t i = 0; i < 2; ++i ) {
+			auto frame = std::make_shared<StubFrame>();
+			frame->Reset(cv::Mat(HEIGHT,WIDTH,CV_8UC1,cv::Scalar(0)),i);
+			EXPECT_EQ(recorder.QueueFrame(frame),i == 0);
+		}
+		EXPECT_EQ(recorder.FrameDropped(),1);
+	}
+	EXPECT_EQ(ledger->Lost(LossLedger::Stage::Recorder),1);
+	LossLedger::Entry entry;
+	ASSERT_TRUE(ledger->Find(1,entry));
+	EXPECT_EQ(entry.Where,LossLedger::Stage::Recorder);
+	EXPECT_STREQ(entry.Reason,"writing is late");
+
+	unlink((dir + "/frames.index").c_str());
+	rmdir(dir.c_str());
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+namespace fort {
+namespace artemis {
+
+class RawFrameGrabberUTest : public ::testing::Test {
+protected:
+	void SetUp();
+	void TearDown();
+
+	std::string d_path;
+};
+
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,226 @@
+#include "RawFrameRecorderTask.hpp"
+
+#include "utils/PosixCall.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include <glog/logging.h>
+
+namespace fort {
+namespace artemis {
+
+RawFrameRecorderTask::RawFrameRecorderTask(const RecordOptions & options,
+                                           const cv::Size & resolution,
+                                           const LossLedger::Ptr & lossLedger)
+	: d_dir(options.OutputDir)
+	, d_lossLedger(lossLedger)
+	, d_stride(std::max(options.Stride,size_t(1)))
+	, d_segmentFrames(std::max(options.SegmentFrames,size_t(1)))
+	, d_header(RawFrameFile::MakeHeader(resolution.width,resolution.height))
+	, d_headerBuffer(nullptr)
+	, d_fd(-1)
+	, d_direct(true)
+	, d_segment(0)
+	, d_slot(0) {
+	if ( d_dir.empty() ) {
+		throw std::invalid_argument("No directory for raw frame recording");
+	}
+	d_frameRecorded.store(0);
+	d_frameDropped.store(0);
+
+	// direct I/O needs aligned buffers, all allocated once.
+	d_headerBuffer = AllocateBuffer(RawFrameFile::HEADER_SIZE);
+	std::memcpy(d_headerBuffer,&d_header,sizeof(d_header));
+	for ( size_t i = 0; i < std::max(options.QueueSize,size_t(1)); ++i ) {
+		d_buffers.push_back(AllocateBuffer(d_header.SlotSize));
+		d_free.push(d_buffers.back());
+	}
+
+	auto indexPath = d_dir + "/frames.index";
+	d_index.open(indexPath,std::ios::out | std::ios::trunc);
+	if ( !d_index ) {
+		throw std::runtime_error("Could not open '" + indexPath + "'");
+	}
+	d_index << "# frame_id,timestamp,segment,slot" << std::endl;
+}
+
+RawFrameRecorderTask::~RawFrameRecorderTask() {
+	for ( auto b : d_buffers ) {
+		free(b);
+	}
+	free(d_headerBuffer);
+}
+
+uint8_t * RawFrameRecorderTask::AllocateBuffer(size_t size) {
+	void * res = nullptr;
+	int err = posix_memalign(&res,RawFrameFile::ALIGNMENT,size);
+	if ( err != 0 ) {
+		throw ARTEMIS_SYSTEM_ERROR(posix_memalign,err);
+	}
+	std::memset(res,0,size);
+	return reinterpret_cast<uint8_t*>(res);
+}
+
+void RawFrameRecorderTask::Run() {
+	LOG(INFO) << "[RawFrameRecorderTask]: started";
+	for (;;) {
+		uint8_t * buffer;
+		d_queue.pop(buffer);
+		if ( buffer == nullptr ) {
+			break;
+		}
+		try {
+			WriteSlot(buffer);
+		} catch ( const std::exception & e ) {
+			auto slot = reinterpret_cast<const RawFrameFile::SlotHeader*>(buffer);
+			Drop(slot->FrameID,"write error",e.what());
+		}
+		d_free.push(buffer);
+	}
+	CloseSegment();
+	LOG(INFO) << "[RawFrameRecorderTask]: recorded " << d_frameRecorded.load()
+	          << " frames, dropped " << d_frameDropped.load();
+	LOG(INFO) << "[RawFrameRecorderTask]: ended";
+}
+
+void RawFrameRecorderTask::CloseQueue() {
+	d_queue.push(nullptr);
+}
+
+bool RawFrameRecorderTask::QueueFrame(const Frame::Ptr & frame) {
+	if ( frame->ID() % d_stride != 0 ) {
+		return true;
+	}
+	const auto & image = frame->ToCV();
+	if ( uint32_t(image.cols) != d_header.Width
+	     || uint32_t(image.rows) != d_header.Height ) {
+		Drop(frame->ID(),"unexpected frame size");
+		return false;
+	}
+
+	uint8_t * buffer;
+	if ( d_free.try_pop(buffer) == false ) {
+		Drop(frame->ID(),"writing is late");
+		return false;
+	}
+
+	RawFrameFile::SlotHeader slot = {.Marker = RawFrameFile::SLOT_MARKER,
+	                                 .Reserved = 0,
+	                                 .FrameID = frame->ID(),
+	                                 .Timestamp = frame->Timestamp(),
+	};
+	std::memcpy(buffer,&slot,sizeof(slot));
+	// copies into the buffer, as it has the right size and type.
+	cv::Mat pixels(image.rows,image.cols,CV_8UC1,buffer + RawFrameFile::DATA_OFFSET);
+	image.copyTo(pixels);
+
+	d_queue.push(buffer);
+	return true;
+}
+
+void RawFrameRecorderTask::Drop(uint64_t frameID,const char * reason,const std::string & details) {
+	auto dropped = d_frameDropped.fetch_add(1) + 1;
+	if ( d_lossLedger ) {
+		d_lossLedger->Record(LossLedger::Stage::Recorder,frameID,reason);
+	}
+	LOG(WARNING) << "[RawFrameRecorderTask]: frame " << frameID
+	             << " not recorded (" << reason
+	             << (details.empty() ? "" : ": " + details)
+	             << "), dropped: " << dropped;
+}
+
+size_t RawFrameRecorderTask::FrameRecorded() const {
+	return d_frameRecorded.load();
+}
+
+size_t RawFrameRecorderTask::FrameDropped() const {
+	return d_frameDropped.load();
+}
+
+void RawFrameRecorderTask::OpenSegment() {
+	auto path = RawFrameFile::SegmentPath(d_dir,d_segment);
+
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	if ( d_direct == true ) {
+		d_fd = open(path.c_str(),flags | O_DIRECT,0644);
+		if ( d_fd < 0 && errno == EINVAL ) {
+			// some filesystems, like tmpfs, do not support direct I/O.
+			LOG(WARNING) << "[RawFrameRecorderTask]: direct I/O is not supported for '"
+			             << path << "', using buffered I/O";
+			d_direct = false;
+		}
+	}
+	if ( d_direct == false ) {
+		d_fd = open(path.c_str(),flags,0644);
+	}
+	if ( d_fd < 0 ) {
+		throw std::system_error(errno,ARTEMIS_SYSTEM_CATEGORY(),"open('" + path + "')");
+	}
+
+	d_slot = 0;
+	++d_segment;
+
+	// reserves the whole segment at once, to avoid fragmentation and
+	// metadata updates while recording.
+	off_t size = RawFrameFile::HEADER_SIZE + d_segmentFrames * d_header.SlotSize;
+	int err = posix_fallocate(d_fd,0,size);
+	if ( err != 0 ) {
+		LOG(WARNING) << "[RawFrameRecorderTask]: could not pre-allocate '" << path
+		             << "': " << std::strerror(err);
+	}
+	WriteAt(d_headerBuffer,RawFrameFile::HEADER_SIZE,0);
+	LOG(INFO) << "[RawFrameRecorderTask]: recording to '" << path << "'";
+}
+
+void RawFrameRecorderTask::CloseSegment() {
+	if ( d_fd < 0 ) {
+		return;
+	}
+	// removes the unused pre-allocated slots.
+	if ( ftruncate(d_fd,RawFrameFile::HEADER_SIZE + d_slot * d_header.SlotSize) != 0 ) {
+		LOG(WARNING) << "[RawFrameRecorderTask]: could not truncate segment: "
+		             << std::strerror(errno);
+	}
+	close(d_fd);
+	d_fd = -1;
+}
+
+void RawFrameRecorderTask::WriteSlot(const uint8_t * buffer) {
+	if ( d_fd < 0 || d_slot >= d_segmentFrames ) {
+		CloseSegment();
+		OpenSegment();
+	}
+
+	WriteAt(buffer,
+	        d_header.SlotSize,
+	        RawFrameFile::HEADER_SIZE + d_slot * d_header.SlotSize);
+
+	auto slot = reinterpret_cast<const RawFrameFile::SlotHeader*>(buffer);
+	d_index << slot->FrameID << ","
+	        << slot->Timestamp << ","
+	        << d_segment - 1 << ","
+	        << d_slot << "\n";
+	++d_slot;
+	d_frameRecorded.fetch_add(1);
+}
+
+void RawFrameRecorderTask::WriteAt(const uint8_t * buffer, size_t size, off_t offset) {
+	while ( size > 0 ) {
+		auto written = pwrite(d_fd,buffer,size,offset);
+		if ( written < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			throw ARTEMIS_SYSTEM_ERROR(pwrite,errno);
+		}
+		buffer += written;
+		size -= written;
+		offset += written;
+	}
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Task.hpp"
+
+#include "FrameGrabber.hpp"
+#include "RawFrameFile.hpp"
+#include "Options.hpp"
+#include "LossLedger.hpp"
+
+#include <tbb/concurrent_queue.h>
+
+#include <atomic>
+#include <fstream>
+
+namespace fort {
+namespace artemis {
+
+// Records raw frames in segment files of RawFrameFile format, to be
+// replayed with RawFrameGrabber from the recording directory.
+// Segments are pre-allocated and written with direct I/O, so the
+// recording does not go through the page cache. A CSV index of all
+// recorded frames is kept in <dir>/frames.index, for offline tools:
+// replay only relies on the segments.
+//
+// Frames are copied in a fixed number of aligned buffers, the task
+// never holds a grabber buffer. When none is free, the frame is
+// dropped from the recording, and accounted for in the loss ledger.
+class RawFrameRecorderTask : public Task {
+public:
+	RawFrameRecorderTask(const RecordOptions & options,
+	                     const cv::Size & resolution,
+	                     const LossLedger::Ptr & lossLedger = LossLedger::Ptr());
+	virtual ~RawFrameRecorderTask();
+
+	void Run() override;
+
+	void CloseQueue();
+
+	// Never blocks. Returns false if the frame is dropped. Must be
+	// called from a single thread.
+	bool QueueFrame(const Frame::Ptr & frame);
+
+	size_t FrameRecorded() const;
+	size_t FrameDropped() const;
+
+private:
+	uint8_t * AllocateBuffer(size_t size);
+
+	void OpenSegment();
+	void CloseSegment();
+	void WriteSlot(const uint8_t * buffer);
+	void WriteAt(const uint8_t * buffer, size_t size, off_t offset);
+
+	// reason is a static string, reported to the loss ledger, details
+	// are only logged.
+	void Drop(uint64_t frameID,const char * reason,const std::string & details = "");
+
+	const std::string    d_dir;
+	LossLedger::Ptr      d_lossLedger;
+	const size_t         d_stride;
+	const size_t         d_segmentFrames;
+	RawFrameFile::Header d_header;
+
+	std::vector<uint8_t*>                   d_buffers;
+	uint8_t                               * d_headerBuffer;
+	tbb::concurrent_bounded_queue<uint8_t*> d_free,d_queue;
+
+	int           d_fd;
+	bool          d_direct;
+	size_t        d_segment;
+	size_t        d_slot;
+	std::ofstream d_index;
+
+	std::atomic<size_t> d_frameRecorded,d_frameDropped;
+};
+
+} // namespace artemis
+} // namespace fort
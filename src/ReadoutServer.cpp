@@ -0,0 +1,229 @@
+#include "ReadoutServer.hpp"
+
+#include <boost/asio/write.hpp>
+#include <boost/asio/error.hpp>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace fort {
+namespace artemis {
+
+#define ReadoutServer_LOG(level,server) LOG(level) << "[ReadoutServer:" \
+	<< (server)->d_port \
+	<< "]: "
+
+ReadoutServer::Subscriber::Subscriber(boost::asio::io_context & context, size_t backlog)
+	: Socket(context)
+	, Backlog(std::max(backlog,size_t(1)))
+	, Head(0)
+	, Count(0)
+	, Sending(false)
+	, Sent(0)
+	, Dropped(0) {
+	Batch.reserve(Backlog.size());
+	Gather.reserve(Backlog.size());
+}
+
+bool ReadoutServer::Subscriber::Push(const MessageBuffer::Ptr & buffer) {
+	bool dropped = false;
+	if ( Count == Backlog.size() ) {
+		// slow consumer: the oldest readout is dropped for it.
+		Backlog[Head].reset();
+		Head = (Head + 1) % Backlog.size();
+		--Count;
+		++Dropped;
+		dropped = true;
+	}
+	Backlog[(Head + Count) % Backlog.size()] = buffer;
+	++Count;
+	return !dropped;
+}
+
+void ReadoutServer::Subscriber::FillBatch(size_t maxBytes) {
+	size_t size = 0;
+	while ( Count > 0 ) {
+		auto & buffer = Backlog[Head];
+		if ( Batch.empty() == false && size + buffer->Size() > maxBytes ) {
+			break;
+		}
+		size += buffer->Size();
+		Gather.push_back(boost::asio::const_buffer(buffer->Data(),buffer->Size()));
+		Batch.push_back(std::move(buffer));
+		buffer.reset();
+		Head = (Head + 1) % Backlog.size();
+		--Count;
+	}
+}
+
+ReadoutServer::Ptr ReadoutServer::Create(boost::asio::io_context & context,
+                                         uint16_t port,
+                                         size_t maxSubscribers,
+                                         size_t backlog,
+                                         size_t maxBatchSize) {
+	Ptr res(new ReadoutServer(context,port,maxSubscribers,backlog,maxBatchSize));
+	res->d_strand.post([res]() { Accept(res); });
+	return res;
+}
+
+ReadoutServer::ReadoutServer(boost::asio::io_context & context,
+                             uint16_t port,
+                             size_t maxSubscribers,
+                             size_t backlog,
+                             size_t maxBatchSize)
+	: d_context(context)
+	, d_strand(context)
+	, d_acceptor(context,boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(),port))
+	, d_port(d_acceptor.local_endpoint().port())
+	, d_maxSubscribers(std::max(maxSubscribers,size_t(1)))
+	, d_backlog(std::max(backlog,size_t(1)))
+	, d_maxBatchSize(std::max(maxBatchSize,size_t(1)))
+	// buffers are shared by all subscribers: at most a backlog and a
+	// batch are in use by the slowest one, and a few are waiting
+	// to be dispatched.
+	, d_bufferPool(2 * d_backlog + 16)
+	, d_stopped(false) {
+	d_subscriberCount.store(0);
+	d_published.store(0);
+	d_dropped.store(0);
+	ReadoutServer_LOG(INFO,this) << "accepting up to " << d_maxSubscribers << " subscribers";
+}
+
+ReadoutServer::~ReadoutServer() {
+}
+
+uint16_t ReadoutServer::Port() const {
+	return d_port;
+}
+
+size_t ReadoutServer::Subscribers() const {
+	return d_subscriberCount.load();
+}
+
+size_t ReadoutServer::Published() const {
+	return d_published.load();
+}
+
+size_t ReadoutServer::Dropped() const {
+	return d_dropped.load();
+}
+
+void ReadoutServer::Accept(const Ptr & self) {
+	if ( self->d_stopped == true ) {
+		return;
+	}
+	auto subscriber = std::make_shared<Subscriber>(self->d_context,self->d_backlog);
+	self->d_acceptor.async_accept(subscriber->Socket,
+	                              self->d_strand.wrap([self,subscriber](const boost::system::error_code & ec) {
+		                                                  if ( ec == boost::asio::error::operation_aborted
+		                                                       || self->d_stopped == true ) {
+			                                                  return;
+		                                                  }
+		                                                  if ( ec ) {
+			                                                  ReadoutServer_LOG(ERROR,self) << "could not accept subscriber: " << ec;
+			                                                  Accept(self);
+			                                                  return;
+		                                                  }
+		                                                  std::ostringstream oss;
+		                                                  boost::system::error_code ignored;
+		                                                  oss << subscriber->Socket.remote_endpoint(ignored);
+		                                                  subscriber->Name = oss.str();
+		                                                  if ( self->d_subscribers.size() >= self->d_maxSubscribers ) {
+			                                                  ReadoutServer_LOG(WARNING,self) << "refusing " << subscriber->Name
+			                                                                                  << ": too many subscribers";
+			                                                  subscriber->Socket.close(ignored);
+		                                                  } else {
+			                                                  ReadoutServer_LOG(INFO,self) << "new subscriber " << subscriber->Name;
+			                                                  self->d_subscribers.push_back(subscriber);
+			                                                  self->d_subscriberCount.store(self->d_subscribers.size());
+		                                                  }
+		                                                  Accept(self);
+	                                                  }));
+}
+
+void ReadoutServer::Publish(const Ptr & self,
+                            const google::protobuf::MessageLite & message,
+                            uint64_t frameID) {
+	if ( self->d_subscriberCount.load() == 0 ) {
+		return;
+	}
+	// serialized once, whatever the number of subscribers.
+	auto buffer = self->d_bufferPool.Serialize(message,frameID);
+	if ( !buffer ) {
+		auto dropped = self->d_dropped.fetch_add(1) + 1;
+		LOG_EVERY_N(WARNING,100) << "[ReadoutServer]: no buffer available, dropped "
+		                         << dropped << " readouts";
+		return;
+	}
+	self->d_published.fetch_add(1);
+	self->d_strand.post([self,buffer]() { Dispatch(self,buffer); });
+}
+
+void ReadoutServer::Dispatch(const Ptr & self, const MessageBuffer::Ptr & buffer) {
+	for ( const auto & subscriber : self->d_subscribers ) {
+		if ( subscriber->Push(buffer) == false ) {
+			LOG_EVERY_N(WARNING,100) << "[ReadoutServer]: " << subscriber->Name
+			                         << " is too slow, dropped " << subscriber->Dropped
+			                         << " readouts";
+		}
+		if ( subscriber->Sending == false ) {
+			ScheduleSend(self,subscriber);
+		}
+	}
+}
+
+void ReadoutServer::ScheduleSend(const Ptr & self, const Subscriber::Ptr & subscriber) {
+	subscriber->Sending = true;
+	subscriber->FillBatch(self->d_maxBatchSize);
+	boost::asio::async_write(subscriber->Socket,
+	                         subscriber->Gather,
+	                         self->d_strand.wrap([self,subscriber](const boost::system::error_code & ec,
+	                                                               std::size_t) {
+		                                             subscriber->Sending = false;
+		                                             subscriber->Sent += subscriber->Batch.size();
+		                                             subscriber->Batch.clear();
+		                                             subscriber->Gather.clear();
+		                                             if ( ec ) {
+			                                             std::ostringstream oss;
+			                                             oss << ec;
+			                                             Remove(self,subscriber,oss.str());
+			                                             return;
+		                                             }
+		                                             if ( subscriber->Count > 0 ) {
+			                                             ScheduleSend(self,subscriber);
+		                                             }
+	                                             }));
+}
+
+void ReadoutServer::Remove(const Ptr & self,
+                           const Subscriber::Ptr & subscriber,
+                           const std::string & reason) {
+	auto fi = std::find(self->d_subscribers.begin(),self->d_subscribers.end(),subscriber);
+	if ( fi == self->d_subscribers.end() ) {
+		return;
+	}
+	ReadoutServer_LOG(INFO,self) << "subscriber " << subscriber->Name << " left (" << reason
+	                             << "), sent: " << subscriber->Sent
+	                             << " dropped: " << subscriber->Dropped;
+	boost::system::error_code ignored;
+	subscriber->Socket.close(ignored);
+	self->d_subscribers.erase(fi);
+	self->d_subscriberCount.store(self->d_subscribers.size());
+}
+
+void ReadoutServer::Stop(const Ptr & self) {
+	self->d_strand.post([self]() {
+		                    self->d_stopped = true;
+		                    boost::system::error_code ignored;
+		                    self->d_acceptor.close(ignored);
+		                    auto subscribers = self->d_subscribers;
+		                    for ( const auto & subscriber : subscribers ) {
+			                    Remove(self,subscriber,"server stopped");
+		                    }
+	                    });
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <google/protobuf/message_lite.h>
+
+#include "MessageBuffer.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace fort {
+namespace artemis {
+
+// Accepts readout subscribers on a TCP port, and sends every
+// published readout to all of them. A readout is serialized once in a
+// reference-counted MessageBuffer shared by all subscribers.
+//
+// Each subscriber has its own bounded backlog. When a subscriber is too
+// slow, its oldest readouts are dropped for it alone, so it never
+// stalls the others nor the publisher.
+class ReadoutServer {
+public:
+	typedef std::shared_ptr<ReadoutServer> Ptr;
+
+	const static size_t DEFAULT_MAX_SUBSCRIBERS = 8;
+	const static size_t DEFAULT_BACKLOG = 64;
+
+	// port may be zero to listen on any free port.
+	static Ptr Create(boost::asio::io_context & context,
+	                  uint16_t port,
+	                  size_t maxSubscribers = DEFAULT_MAX_SUBSCRIBERS,
+	                  size_t backlog = DEFAULT_BACKLOG,
+	                  size_t maxBatchSize = 64 * 1024);
+
+	~ReadoutServer();
+
+	// thread-safe function.
+	static void Publish(const Ptr & server,
+	                    const google::protobuf::MessageLite & m,
+	                    uint64_t frameID = MessageBuffer::NO_FRAME_ID);
+
+	// Closes the listening socket and all subscribers. thread-safe.
+	static void Stop(const Ptr & server);
+
+	uint16_t Port() const;
+
+	// thread-safe functions.
+	size_t Subscribers() const;
+	size_t Published() const;
+	// readouts that could not be published to any subscriber, as all
+	// buffers were in use.
+	size_t Dropped() const;
+
+private:
+	struct Subscriber {
+		typedef std::shared_ptr<Subscriber> Ptr;
+
+		Subscriber(boost::asio::io_context & context, size_t backlog);
+
+		// Adds buffer to the backlog, dropping the oldest one if
+		// full. Returns false if a readout was dropped.
+		bool Push(const MessageBuffer::Ptr & buffer);
+		// Moves the oldest readouts in the batch, up to maxBytes but
+		// at least one.
+		void FillBatch(size_t maxBytes);
+
+		boost::asio::ip::tcp::socket           Socket;
+		std::string                            Name;
+		// circular backlog, Count readouts from Head.
+		std::vector<MessageBuffer::Ptr>        Backlog;
+		size_t                                 Head,Count;
+		std::vector<MessageBuffer::Ptr>        Batch;
+		std::vector<boost::asio::const_buffer> Gather;
+		bool                                   Sending;
+		size_t                                 Sent,Dropped;
+	};
+
+	ReadoutServer(boost::asio::io_context & context,
+	              uint16_t port,
+	              size_t maxSubscribers,
+	              size_t backlog,
+	              size_t maxBatchSize);
+
+	// Strand only functions.
+	static void Accept(const Ptr & self);
+	static void Dispatch(const Ptr & self, const MessageBuffer::Ptr & buffer);
+	static void ScheduleSend(const Ptr & self, const Subscriber::Ptr & subscriber);
+	static void Remove(const Ptr & self, const Subscriber::Ptr & subscriber, const std::string & reason);
+
+	boost::asio::io_context         & d_context;
+	boost::asio::io_context::strand   d_strand;
+	boost::asio::ip::tcp::acceptor    d_acceptor;
+	uint16_t                          d_port;
+	size_t                            d_maxSubscribers;
+	size_t                            d_backlog;
+	size_t                            d_maxBatchSize;
+
+	// must outlive the subscribers backlogs.
+	MessageBufferPool                 d_bufferPool;
+	// Strand only.
+	std::vector<Subscriber::Ptr>      d_subscribers;
+	bool                              d_stopped;
+
+	std::atomic<size_t>               d_subscriberCount,d_published,d_dropped;
+};
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,90 @@
+#include "ReadoutServerUTest.hpp"
+
+#include "ReadoutServer.hpp"
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+#include <fort/hermes/FrameReadout.pb.h>
+
+#include <numeric>
+
+namespace fort {
+namespace artemis {
+
+ReadoutServerUTest::ReadoutServerUTest()
+	: d_guard(d_context.get_executor()) {
+}
+
+void ReadoutServerUTest::SetUp() {
+	d_thread = std::thread([this]() { d_context.run(); });
+}
+
+void ReadoutServerUTest::TearDown() {
+	d_guard.reset();
+	d_context.stop();
+	d_thread.join();
+}
+
+static void WaitFor(const std::function<bool()> & condition) {
+	for ( size_t i = 0; i < 1000 && condition() == false; ++i ) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+TEST_F(ReadoutServerUTest,FansOutToAllSubscribers) {
+	auto server = ReadoutServer::Create(d_context,0);
+
+	boost::asio::io_context clientContext;
+	std::vector<std::shared_ptr<boost::asio::ip::tcp::socket>> clients;
+	for ( size_t i = 0; i < 2; ++i ) {
+		auto client = std::make_shared<boost::asio::ip::tcp::socket>(clientContext);
+		client->connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(),
+		                                               server->Port()));
+		clients.push_back(client);
+	}
+	WaitFor([&server]() { return server->Subscribers() == 2; });
+	ASSERT_EQ(server->Subscribers(),2);
+
+	std::vector<size_t> sizes;
+	for ( size_t i = 0; i < 4; ++i ) {
+		hermes::FrameReadout m;
+		m.set_frameid(i+1);
+		m.set_timestamp(20000*(i+1));
+		sizes.push_back(m.ByteSizeLong() + 1);
+		ReadoutServer::Publish(server,m,i+1);
+	}
+	EXPECT_EQ(server->Published(),4);
+
+	for ( const auto & client : clients ) {
+		std::vector<char> data(std::accumulate(sizes.begin(),sizes.end(),size_t(0)));
+		boost::asio::read(*client,boost::asio::buffer(data));
+		google::protobuf::io::ArrayInputStream input(data.data(),data.size());
+		for ( size_t i = 0; i < 4; ++i ) {
+			hermes::FrameReadout m;
+			ASSERT_TRUE(google::protobuf::util::ParseDelimitedFromZeroCopyStream(&m,&input,nullptr));
+			EXPECT_EQ(m.frameid(),i+1);
+			EXPECT_EQ(m.timestamp(),20000*(i+1));
+		}
+	}
+
+	clients.clear();
+	ReadoutServer::Stop(server);
+	WaitFor([&server]() { return server->Subscribers() == 0; });
+	EXPECT_EQ(server->Subscribers(),0);
+}
+
+TEST_F(ReadoutServerUTest,DoesNotSerializeWithoutSubscribers) {
+	auto server = ReadoutServer::Create(d_context,0);
+	hermes::FrameReadout m;
+	ReadoutServer::Publish(server,m,1);
+	EXPECT_EQ(server->Published(),0);
+	EXPECT_EQ(server->Dropped(),0);
+	ReadoutServer::Stop(server);
+}
+
+} // namespace artemis
+} // namespace fort
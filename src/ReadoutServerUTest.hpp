@@ -0,0 +1,28 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+
+#include <thread>
+
+namespace fort {
+namespace artemis {
+
+class ReadoutServerUTest : public ::testing::Test {
+protected:
+	ReadoutServerUTest();
+
+	void SetUp();
+	void TearDown();
+
+	typedef boost::asio::executor_work_guard<boost::asio::io_context::executor_type> WorkGuard;
+
+	boost::asio::io_context d_context;
+	WorkGuard               d_guard;
+	std::thread             d_thread;
+};
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,251 @@
+#include "ReadoutSpool.hpp"
+
+#include "utils/PosixCall.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include <glog/logging.h>
+
+namespace fort {
+namespace artemis {
+
+const size_t   ReadoutSpool::HEADER_SIZE;
+const size_t   ReadoutSpool::ALIGNMENT;
+const uint64_t ReadoutSpool::MAGIC;
+const uint32_t ReadoutSpool::VERSION;
+
+ReadoutSpool::ReadoutSpool(const std::string & path, size_t capacity)
+	: d_path(path)
+	, d_mapped(nullptr)
+	, d_capacity(std::max(capacity,HEADER_SIZE + RecordSize(1)))
+	, d_header(nullptr)
+	, d_dropped(0) {
+	if ( path.empty() ) {
+		throw std::invalid_argument("No path for the readout spool");
+	}
+
+	int fd = open(path.c_str(),O_RDWR | O_CREAT,0644);
+	if ( fd < 0 ) {
+		throw std::system_error(errno,ARTEMIS_SYSTEM_CATEGORY(),"open('" + path + "')");
+	}
+	struct stat info;
+	if ( fstat(fd,&info) < 0 ) {
+		int err = errno;
+		close(fd);
+		throw ARTEMIS_SYSTEM_ERROR(fstat,err);
+	}
+	bool existing = size_t(info.st_size) == d_capacity;
+	if ( existing == false && ftruncate(fd,d_capacity) < 0 ) {
+		int err = errno;
+		close(fd);
+		throw ARTEMIS_SYSTEM_ERROR(ftruncate,err);
+	}
+	auto mapped = mmap(nullptr,d_capacity,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+	// the mapping stays valid once the file is closed.
+	close(fd);
+	if ( mapped == MAP_FAILED ) {
+		throw ARTEMIS_SYSTEM_ERROR(mmap,errno);
+	}
+	d_mapped = reinterpret_cast<uint8_t*>(mapped);
+	d_header = reinterpret_cast<Header*>(d_mapped);
+
+	if ( existing == true && Valid() == true ) {
+		if ( d_header->Count > 0 ) {
+			LOG(INFO) << "[ReadoutSpool]: " << d_header->Count
+			          << " readouts left in '" << path << "' will be replayed";
+		}
+		return;
+	}
+	if ( existing == true ) {
+		LOG(WARNING) << "[ReadoutSpool]: '" << path << "' is not a valid spool, discarding its content";
+	}
+	Reset();
+}
+
+ReadoutSpool::~ReadoutSpool() {
+	msync(d_mapped,d_capacity,MS_ASYNC);
+	munmap(d_mapped,d_capacity);
+}
+
+size_t ReadoutSpool::RecordSize(size_t size) {
+	size += sizeof(RecordHeader);
+	return ((size + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+}
+
+bool ReadoutSpool::ReadRecord(size_t & offset, RecordHeader & header) const {
+	if ( d_header->WrapOffset != 0 && offset == d_header->WrapOffset ) {
+		offset = HEADER_SIZE;
+	}
+	// records at or after the read offset are the oldest ones.
+	size_t end = d_header->WriteOffset;
+	if ( d_header->WrapOffset != 0 && offset >= d_header->ReadOffset ) {
+		end = d_header->WrapOffset;
+	}
+	if ( offset > end || end - offset < sizeof(RecordHeader) ) {
+		return false;
+	}
+	std::memcpy(&header,d_mapped + offset,sizeof(header));
+	return header.Size <= end - offset
+		&& RecordSize(header.Size) <= end - offset;
+}
+
+bool ReadoutSpool::Valid() const {
+	if ( d_header->Magic != MAGIC
+	     || d_header->Version != VERSION
+	     || d_header->Capacity != d_capacity
+	     || d_header->ReadOffset < HEADER_SIZE
+	     || d_header->WriteOffset < HEADER_SIZE
+	     || d_header->WriteOffset > d_capacity ) {
+		return false;
+	}
+	if ( d_header->WrapOffset == 0 ) {
+		if ( d_header->ReadOffset > d_header->WriteOffset ) {
+			return false;
+		}
+	} else if ( d_header->WriteOffset > d_header->ReadOffset
+	            || d_header->ReadOffset >= d_header->WrapOffset
+	            || d_header->WrapOffset > d_capacity ) {
+		return false;
+	}
+	// a record torn by a crash, or a corrupted one, must not make us
+	// read past the other records.
+	size_t offset = d_header->ReadOffset;
+	for ( size_t i = 0; i < d_header->Count; ++i ) {
+		RecordHeader header;
+		if ( ReadRecord(offset,header) == false ) {
+			return false;
+		}
+		offset += RecordSize(header.Size);
+	}
+	return offset == d_header->WriteOffset;
+}
+
+void ReadoutSpool::Reset() {
+	*d_header = {.Magic = MAGIC,
+	             .Version = VERSION,
+	             .Reserved = 0,
+	             .Capacity = d_capacity,
+	             .ReadOffset = HEADER_SIZE,
+	             .WriteOffset = HEADER_SIZE,
+	             .WrapOffset = 0,
+	             .Count = 0,
+	};
+}
+
+void ReadoutSpool::Discard(const char * reason) {
+	LOG(ERROR) << "[ReadoutSpool]: " << reason << ", discarding "
+	           << d_header->Count << " readouts from '" << d_path << "'";
+	d_dropped += d_header->Count;
+	Reset();
+}
+
+bool ReadoutSpool::Append(uint64_t frameID, const uint8_t * data, size_t size) {
+	size_t recordSize = RecordSize(size);
+	size_t offset = d_header->WriteOffset;
+	if ( d_header->WrapOffset != 0 ) {
+		// stops before the oldest records.
+		if ( offset + recordSize > d_header->ReadOffset ) {
+			++d_dropped;
+			return false;
+		}
+	} else if ( offset + recordSize > d_capacity ) {
+		// wraps to the space freed by the replayed records.
+		if ( d_header->Count == 0 || HEADER_SIZE + recordSize > d_header->ReadOffset ) {
+			++d_dropped;
+			return false;
+		}
+		offset = HEADER_SIZE;
+	}
+	auto record = d_mapped + offset;
+	RecordHeader header = {.FrameID = frameID, .Size = size};
+	std::memcpy(record,&header,sizeof(header));
+	std::memcpy(record + sizeof(header),data,size);
+	// offsets are updated once the record is complete.
+	if ( offset != d_header->WriteOffset ) {
+		d_header->WrapOffset = d_header->WriteOffset;
+	}
+	d_header->WriteOffset = offset + recordSize;
+	++d_header->Count;
+	return true;
+}
+
+size_t ReadoutSpool::Peek(std::vector<Record> & records, size_t maxBytes) {
+	records.clear();
+	size_t offset = d_header->ReadOffset;
+	size_t bytes = 0;
+	for ( size_t i = 0; i < d_header->Count; ++i ) {
+		RecordHeader header;
+		if ( ReadRecord(offset,header) == false ) {
+			records.clear();
+			Discard("corrupted record");
+			return 0;
+		}
+		if ( records.empty() == false && bytes + header.Size > maxBytes ) {
+			break;
+		}
+		records.push_back({.FrameID = header.FrameID,
+		                   .Data = d_mapped + offset + sizeof(header),
+		                   .Size = header.Size});
+		bytes += header.Size;
+		offset += RecordSize(header.Size);
+	}
+	return records.size();
+}
+
+void ReadoutSpool::Consume(size_t count) {
+	for ( ; count > 0 && d_header->Count > 0; --count ) {
+		size_t offset = d_header->ReadOffset;
+		RecordHeader header;
+		if ( ReadRecord(offset,header) == false ) {
+			Discard("corrupted record");
+			return;
+		}
+		d_header->ReadOffset = offset + RecordSize(header.Size);
+		if ( d_header->ReadOffset == d_header->WrapOffset ) {
+			// the oldest records are now at the beginning.
+			d_header->ReadOffset = HEADER_SIZE;
+			d_header->WrapOffset = 0;
+		}
+		--d_header->Count;
+	}
+	if ( d_header->Count == 0 ) {
+		// starts over, the whole capacity is available again.
+		Reset();
+	}
+}
+
+bool ReadoutSpool::Empty() const {
+	return d_header->Count == 0;
+}
+
+size_t ReadoutSpool::Count() const {
+	return d_header->Count;
+}
+
+size_t ReadoutSpool::Bytes() const {
+	if ( d_header->WrapOffset == 0 ) {
+		return d_header->WriteOffset - d_header->ReadOffset;
+	}
+	return d_header->WrapOffset - d_header->ReadOffset
+		+ d_header->WriteOffset - HEADER_SIZE;
+}
+
+size_t ReadoutSpool::Capacity() const {
+	return d_capacity;
+}
+
+size_t ReadoutSpool::Dropped() const {
+	return d_dropped;
+}
+
+const std::string & ReadoutSpool::Path() const {
+	return d_path;
+}
+
+} // namespace artemis
+} // namespace fort
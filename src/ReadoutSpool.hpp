@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fort {
+namespace artemis {
+
+// Circular, memory-mapped file holding serialized readouts while they
+// cannot be sent. Records are replayed in the order they were
+// appended, and their space is reused once replayed: a record that
+// does not fit at the end of the file wraps to its beginning. Its size
+// is fixed at creation: records that do not fit are refused and
+// counted as dropped.
+//
+// Offsets are kept in the file header, so a spool left by a previous
+// run is replayed as well, once all its records are checked to lie
+// within them. Records are written to the page cache: they survive a
+// crash of the process, not of the host.
+//
+// Not thread-safe, Connection only uses it from its strand.
+class ReadoutSpool {
+public:
+	typedef std::shared_ptr<ReadoutSpool> Ptr;
+
+	struct Record {
+		uint64_t        FrameID;
+		const uint8_t * Data;
+		size_t          Size;
+	};
+
+	const static size_t   HEADER_SIZE = 4096;
+	const static size_t   ALIGNMENT   = 8;
+	// "ARTSPOOL" read as a little endian integer.
+	const static uint64_t MAGIC       = 0x4c4f4f5053545241ULL;
+	const static uint32_t VERSION     = 2;
+
+	// capacity is the total size of the file, including its header.
+	ReadoutSpool(const std::string & path, size_t capacity);
+	~ReadoutSpool();
+
+	ReadoutSpool(const ReadoutSpool &) = delete;
+	ReadoutSpool & operator=(const ReadoutSpool &) = delete;
+
+	// Returns false, and counts the record as dropped, if it does not
+	// fit in the free space.
+	bool Append(uint64_t frameID, const uint8_t * data, size_t size);
+
+	// Fills records with the oldest records, as long as their total
+	// size is lower than maxBytes, but at least one. Records point
+	// in the mapping and stay valid until they are consumed. A
+	// corrupted record discards the content of the spool.
+	size_t Peek(std::vector<Record> & records, size_t maxBytes);
+
+	// Removes the count oldest records.
+	void Consume(size_t count);
+
+	bool Empty() const;
+	size_t Count() const;
+	size_t Bytes() const;
+	size_t Capacity() const;
+
+	size_t Dropped() const;
+
+	const std::string & Path() const;
+
+private:
+	struct Header {
+		uint64_t Magic;
+		uint32_t Version;
+		uint32_t Reserved;
+		uint64_t Capacity;
+		uint64_t ReadOffset;
+		uint64_t WriteOffset;
+		// end of the oldest records once writing wrapped to the
+		// beginning of the file, zero otherwise.
+		uint64_t WrapOffset;
+		uint64_t Count;
+	};
+
+	struct RecordHeader {
+		uint64_t FrameID;
+		uint64_t Size;
+	};
+
+	static_assert(sizeof(Header) <= HEADER_SIZE,"Header does not fit");
+
+	static size_t RecordSize(size_t size);
+
+	// Reads the header of the record at offset, moving offset to the
+	// beginning of the file if it is at the wrap offset. Returns false
+	// if the record does not end before the next ones.
+	bool ReadRecord(size_t & offset, RecordHeader & header) const;
+
+	bool Valid() const;
+	void Reset();
+	void Discard(const char * reason);
+
+	std::string d_path;
+	uint8_t   * d_mapped;
+	size_t      d_capacity;
+	Header    * d_header;
+	size_t      d_dropped;
+};
+
+} // namespace artemis
+} // namespace fort
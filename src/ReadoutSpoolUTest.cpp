@@ -0,0 +1,140 @@
+#include "ReadoutSpoolUTest.hpp"
+
+#include "ReadoutSpool.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fort {
+namespace artemis {
+
+void ReadoutSpoolUTest::SetUp() {
+	d_path = ::testing::TempDir() + "/artemis-spool-" + std::to_string(getpid()) + ".spool";
+}
+
+void ReadoutSpoolUTest::TearDown() {
+	unlink(d_path.c_str());
+}
+
+static std::string ToString(const ReadoutSpool::Record & record) {
+	return std::string(reinterpret_cast<const char*>(record.Data),record.Size);
+}
+
+static bool Append(ReadoutSpool & spool, uint64_t frameID, const std::string & data) {
+	return spool.Append(frameID,reinterpret_cast<const uint8_t*>(data.c_str()),data.size());
+}
+
+TEST_F(ReadoutSpoolUTest,ReplaysInOrder) {
+	ReadoutSpool spool(d_path,8192);
+	EXPECT_TRUE(spool.Empty());
+	EXPECT_TRUE(Append(spool,1,"foo"));
+	EXPECT_TRUE(Append(spool,2,"barbaz"));
+	EXPECT_TRUE(Append(spool,3,"a"));
+	EXPECT_EQ(spool.Count(),3);
+
+	std::vector<ReadoutSpool::Record> records;
+	// at least one record is returned, whatever the limit.
+	ASSERT_EQ(spool.Peek(records,0),1);
+	EXPECT_EQ(records[0].FrameID,1);
+	EXPECT_EQ(ToString(records[0]),"foo");
+
+	ASSERT_EQ(spool.Peek(records,9),2);
+	EXPECT_EQ(records[1].FrameID,2);
+	EXPECT_EQ(ToString(records[1]),"barbaz");
+	spool.Consume(2);
+
+	ASSERT_EQ(spool.Peek(records,1024),1);
+	EXPECT_EQ(records[0].FrameID,3);
+	EXPECT_EQ(ToString(records[0]),"a");
+	spool.Consume(1);
+	EXPECT_TRUE(spool.Empty());
+	EXPECT_EQ(spool.Bytes(),0);
+}
+
+TEST_F(ReadoutSpoolUTest,IsBoundedBySize) {
+	ReadoutSpool spool(d_path,ReadoutSpool::HEADER_SIZE + 64);
+	std::string data(40,'x');
+	EXPECT_TRUE(Append(spool,1,data));
+	EXPECT_FALSE(Append(spool,2,data));
+	EXPECT_EQ(spool.Dropped(),1);
+	EXPECT_EQ(spool.Count(),1);
+
+	// space is available again once fully replayed.
+	spool.Consume(1);
+	EXPECT_TRUE(Append(spool,3,data));
+}
+
+TEST_F(ReadoutSpoolUTest,ReusesReplayedSpace) {
+	// room for three records.
+	ReadoutSpool spool(d_path,ReadoutSpool::HEADER_SIZE + 3 * 64);
+	std::string data(40,'x');
+	EXPECT_TRUE(Append(spool,1,data));
+	EXPECT_TRUE(Append(spool,2,data));
+	EXPECT_TRUE(Append(spool,3,data));
+	EXPECT_FALSE(Append(spool,4,data));
+
+	// the space of the replayed record is used, before the others.
+	spool.Consume(1);
+	EXPECT_TRUE(Append(spool,5,data));
+	EXPECT_FALSE(Append(spool,6,data));
+	EXPECT_EQ(spool.Bytes(),3 * 56);
+
+	std::vector<ReadoutSpool::Record> records;
+	std::vector<uint64_t> IDs;
+	while ( spool.Peek(records,0) > 0 ) {
+		IDs.push_back(records[0].FrameID);
+		spool.Consume(1);
+	}
+	EXPECT_EQ(IDs,std::vector<uint64_t>({2,3,5}));
+	EXPECT_TRUE(spool.Empty());
+	EXPECT_EQ(spool.Bytes(),0);
+}
+
+TEST_F(ReadoutSpoolUTest,DiscardsCorruptedRecords) {
+	uint64_t size = 1 << 20;
+	{
+		ReadoutSpool spool(d_path,8192);
+		Append(spool,1,"foo");
+		Append(spool,2,"bar");
+		int fd = open(d_path.c_str(),O_WRONLY);
+		ASSERT_GE(fd,0);
+		// the size of the first record, as seen through the mapping.
+		ASSERT_EQ(pwrite(fd,&size,sizeof(size),ReadoutSpool::HEADER_SIZE + 8),sizeof(size));
+		close(fd);
+
+		std::vector<ReadoutSpool::Record> records;
+		EXPECT_EQ(spool.Peek(records,1024),0);
+		EXPECT_TRUE(spool.Empty());
+		EXPECT_EQ(spool.Dropped(),2);
+		Append(spool,3,"foo");
+	}
+	int fd = open(d_path.c_str(),O_WRONLY);
+	ASSERT_GE(fd,0);
+	ASSERT_EQ(pwrite(fd,&size,sizeof(size),ReadoutSpool::HEADER_SIZE + 8),sizeof(size));
+	close(fd);
+	// a corrupted spool left by a previous run is not replayed.
+	ReadoutSpool spool(d_path,8192);
+	EXPECT_TRUE(spool.Empty());
+}
+
+TEST_F(ReadoutSpoolUTest,SurvivesRestart) {
+	{
+		ReadoutSpool spool(d_path,8192);
+		Append(spool,1,"foo");
+		Append(spool,2,"bar");
+		spool.Consume(1);
+	}
+	{
+		ReadoutSpool spool(d_path,8192);
+		std::vector<ReadoutSpool::Record> records;
+		ASSERT_EQ(spool.Peek(records,1024),1);
+		EXPECT_EQ(records[0].FrameID,2);
+		EXPECT_EQ(ToString(records[0]),"bar");
+	}
+	// a different size discards the content.
+	ReadoutSpool spool(d_path,16384);
+	EXPECT_TRUE(spool.Empty());
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+namespace fort {
+namespace artemis {
+
+class ReadoutSpoolUTest : public ::testing::Test {
+protected:
+	void SetUp();
+	void TearDown();
+
+	std::string d_path;
+};
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <semaphore.h>
+
+#include <atomic>
+#include <vector>
+#include <system_error>
+#include <cerrno>
+
+namespace fort {
+namespace artemis {
+
+// Bounded lock-free ring between a single producer thread and a
+// single consumer thread. Slots are allocated once at construction.
+// The producer is either told when the ring is full and chooses what
+// to do with the value, or blocks until a slot is free. The consumer
+// may block until a value is available. Both stop blocking once the
+// ring is closed.
+template <typename T>
+class SPSCRing {
+public:
+	// capacity is rounded up to the next power of two.
+	SPSCRing(size_t capacity)
+		: d_head(0)
+		, d_tail(0)
+		, d_closed(false) {
+		size_t size = 1;
+		while ( size < capacity ) {
+			size <<= 1;
+		}
+		d_mask = size - 1;
+		d_slots.resize(size);
+		if ( sem_init(&d_available,0,0) != 0 ) {
+			throw std::system_error(errno,std::generic_category(),"sem_init");
+		}
+		if ( sem_init(&d_free,0,size) != 0 ) {
+			int err = errno;
+			sem_destroy(&d_available);
+			throw std::system_error(err,std::generic_category(),"sem_init");
+		}
+	}
+
+	~SPSCRing() {
+		sem_destroy(&d_free);
+		sem_destroy(&d_available);
+	}
+
+	SPSCRing(const SPSCRing &) = delete;
+	SPSCRing & operator=(const SPSCRing &) = delete;
+
+	// Producer only. Returns false, leaving value untouched, if the
+	// ring is full or closed.
+	bool TryPush(T & value) {
+		if ( sem_trywait(&d_free) != 0 ) {
+			return false;
+		}
+		return PutUnlessClosed(value);
+	}
+
+	// Producer only. Blocks until a slot is free. Returns false,
+	// leaving value untouched, once the ring is closed.
+	bool Push(T & value) {
+		Wait(d_free);
+		return PutUnlessClosed(value);
+	}
+
+	// Either thread. Wakes up the consumer, which will receive the
+	// remaining values before Pop() returns false, and a producer
+	// blocked in Push().
+	void Close() {
+		d_closed.store(true,std::memory_order_release);
+		sem_post(&d_available);
+		sem_post(&d_free);
+	}
+
+	// Consumer only. Blocks until a value is available, returns false
+	// once the ring is closed and empty.
+	bool Pop(T & value) {
+		Wait(d_available);
+		if ( Take(value) == true ) {
+			return true;
+		}
+		// the ring is closed, let any later call return as well.
+		sem_post(&d_available);
+		return false;
+	}
+
+	// Consumer only. Returns false if no value is available.
+	bool TryPop(T & value) {
+		if ( sem_trywait(&d_available) != 0 ) {
+			return false;
+		}
+		if ( Take(value) == true ) {
+			return true;
+		}
+		sem_post(&d_available);
+		return false;
+	}
+
+	// Number of values waiting in the ring. It is a lower bound from
+	// the consumer thread, and an upper bound from the producer one.
+	size_t Size() const {
+		size_t head = d_head.load(std::memory_order_acquire);
+		return d_tail.load(std::memory_order_acquire) - head;
+	}
+
+	size_t Capacity() const {
+		return d_mask + 1;
+	}
+
+	bool Closed() const {
+		return d_closed.load(std::memory_order_acquire);
+	}
+
+private:
+	// avoids false sharing between the producer and consumer indices.
+	const static size_t CACHE_LINE_SIZE = 64;
+
+	static void Wait(sem_t & semaphore) {
+		while ( sem_wait(&semaphore) != 0 ) {
+			if ( errno != EINTR ) {
+				throw std::system_error(errno,std::generic_category(),"sem_wait");
+			}
+		}
+	}
+
+	// called with a free slot taken.
+	bool PutUnlessClosed(T & value) {
+		if ( Closed() == true ) {
+			// the slot may be the one Close() released, it is given
+			// back so any later call returns as well.
+			sem_post(&d_free);
+			return false;
+		}
+		size_t tail = d_tail.load(std::memory_order_relaxed);
+		d_slots[tail & d_mask] = std::move(value);
+		d_tail.store(tail + 1,std::memory_order_release);
+		sem_post(&d_available);
+		return true;
+	}
+
+	bool Take(T & value) {
+		size_t head = d_head.load(std::memory_order_relaxed);
+		if ( head == d_tail.load(std::memory_order_acquire) ) {
+			return false;
+		}
+		auto & slot = d_slots[head & d_mask];
+		value = std::move(slot);
+		// releases any resource held by the slot right away.
+		slot = T();
+		d_head.store(head + 1,std::memory_order_release);
+		sem_post(&d_free);
+		return true;
+	}
+
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> d_head;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> d_tail;
+	alignas(CACHE_LINE_SIZE) std::atomic<bool>   d_closed;
+	size_t                                       d_mask;
+	std::vector<T>                               d_slots;
+	sem_t                                        d_available;
+	sem_t                                        d_free;
+};
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,124 @@
+#include "SPSCRingUTest.hpp"
+
+#include "SPSCRing.hpp"
+
+#include <memory>
+#include <thread>
+
+namespace fort {
+namespace artemis {
+
+TEST_F(SPSCRingUTest,RoundsCapacity) {
+	EXPECT_EQ(SPSCRing<int>(1).Capacity(),1);
+	EXPECT_EQ(SPSCRing<int>(3).Capacity(),4);
+	EXPECT_EQ(SPSCRing<int>(4).Capacity(),4);
+	EXPECT_EQ(SPSCRing<int>(5).Capacity(),8);
+}
+
+TEST_F(SPSCRingUTest,IsBoundedFIFO) {
+	SPSCRing<int> ring(4);
+	for ( int i = 0; i < 4; ++i ) {
+		EXPECT_TRUE(ring.TryPush(i));
+	}
+	int value = 42;
+	EXPECT_FALSE(ring.TryPush(value));
+	EXPECT_EQ(value,42);
+	EXPECT_EQ(ring.Size(),4);
+
+	for ( int i = 0; i < 4; ++i ) {
+		EXPECT_TRUE(ring.TryPop(value));
+		EXPECT_EQ(value,i);
+	}
+	EXPECT_FALSE(ring.TryPop(value));
+	EXPECT_EQ(ring.Size(),0);
+}
+
+TEST_F(SPSCRingUTest,ReleasesPoppedValues) {
+	SPSCRing<std::shared_ptr<int>> ring(2);
+	auto value = std::make_shared<int>(1);
+	std::weak_ptr<int> observer = value;
+	EXPECT_TRUE(ring.TryPush(value));
+	EXPECT_FALSE(value);
+	EXPECT_TRUE(ring.TryPop(value));
+	value.reset();
+	EXPECT_TRUE(observer.expired());
+}
+
+TEST_F(SPSCRingUTest,CloseUnblocksConsumer) {
+	SPSCRing<int> ring(2);
+	int value = 1;
+	ring.TryPush(value);
+	std::thread consumer([&ring]() {
+		                     int value;
+		                     EXPECT_TRUE(ring.Pop(value));
+		                     EXPECT_EQ(value,1);
+		                     EXPECT_FALSE(ring.Pop(value));
+		                     EXPECT_FALSE(ring.Pop(value));
+	                     });
+	ring.Close();
+	consumer.join();
+	EXPECT_TRUE(ring.Closed());
+}
+
+TEST_F(SPSCRingUTest,TransfersInOrder) {
+	const static int N = 100000;
+	SPSCRing<int> ring(8);
+	std::thread producer([&ring]() {
+		                     for ( int i = 0; i < N; ) {
+			                     int value = i;
+			                     if ( ring.TryPush(value) == true ) {
+				                     ++i;
+			                     } else {
+				                     std::this_thread::yield();
+			                     }
+		                     }
+		                     ring.Close();
+	                     });
+	int expected = 0,value;
+	while( ring.Pop(value) == true ) {
+		EXPECT_EQ(value,expected);
+		++expected;
+	}
+	producer.join();
+	EXPECT_EQ(expected,N);
+}
+
+TEST_F(SPSCRingUTest,PushBlocksUntilFree) {
+	const static int N = 100000;
+	SPSCRing<int> ring(8);
+	std::thread producer([&ring]() {
+		                     for ( int i = 0; i < N; ++i ) {
+			                     int value = i;
+			                     EXPECT_TRUE(ring.Push(value));
+		                     }
+		                     ring.Close();
+	                     });
+	int expected = 0,value;
+	while( ring.Pop(value) == true ) {
+		EXPECT_EQ(value,expected);
+		++expected;
+	}
+	producer.join();
+	EXPECT_EQ(expected,N);
+}
+
+TEST_F(SPSCRingUTest,CloseUnblocksProducer) {
+	SPSCRing<int> ring(2);
+	int value = 1;
+	EXPECT_TRUE(ring.Push(value));
+	EXPECT_TRUE(ring.Push(value));
+	std::thread producer([&ring]() {
+		                     int value = 2;
+		                     EXPECT_FALSE(ring.Push(value));
+		                     EXPECT_EQ(value,2);
+		                     EXPECT_FALSE(ring.Push(value));
+		                     EXPECT_FALSE(ring.TryPush(value));
+	                     });
+	// the consumer stops first.
+	ring.Close();
+	producer.join();
+	EXPECT_EQ(ring.Size(),2);
+}
+
+} // namespace artemis
+} // namespace fort
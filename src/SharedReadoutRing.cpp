@@ -0,0 +1,275 @@
+#include "SharedReadoutRing.hpp"
+
+#include "utils/PosixCall.hpp"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+
+#include <glog/logging.h>
+
+namespace fort {
+namespace artemis {
+
+const size_t   SharedReadoutRing::HEADER_SIZE;
+const size_t   SharedReadoutRing::RECORD_ALIGNMENT;
+const size_t   SharedReadoutRing::DEFAULT_CAPACITY;
+const uint64_t SharedReadoutRing::MAGIC;
+const uint32_t SharedReadoutRing::VERSION;
+const uint32_t SharedReadoutRing::PADDING;
+
+// the futex word is shared between processes: no FUTEX_PRIVATE_FLAG.
+static long Futex(std::atomic<uint32_t> * word, int op, uint32_t value, const struct timespec * timeout) {
+	return syscall(SYS_futex,reinterpret_cast<uint32_t*>(word),op,value,timeout,nullptr,0);
+}
+
+std::string SharedReadoutRing::SegmentName(const std::string & name) {
+	if ( name.empty() || name[0] != '/' ) {
+		return "/" + name;
+	}
+	return name;
+}
+
+size_t SharedReadoutRing::RecordSize(size_t size) {
+	size += sizeof(RecordHeader);
+	return ((size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT) * RECORD_ALIGNMENT;
+}
+
+SharedReadoutRing::SharedReadoutRing(const std::string & name, size_t capacity)
+	: d_name(SegmentName(name))
+	, d_size(0)
+	, d_mapped(nullptr)
+	, d_header(nullptr)
+	, d_data(nullptr) {
+	size_t dataSize = 4 * RECORD_ALIGNMENT;
+	while ( dataSize < capacity ) {
+		dataSize <<= 1;
+	}
+	d_size = HEADER_SIZE + dataSize;
+
+	// consumers of a previous segment keep their mapping, and have to
+	// open the new one.
+	shm_unlink(d_name.c_str());
+	int fd = shm_open(d_name.c_str(),O_RDWR | O_CREAT | O_EXCL,0660);
+	if ( fd < 0 ) {
+		throw std::system_error(errno,ARTEMIS_SYSTEM_CATEGORY(),"shm_open('" + d_name + "')");
+	}
+	if ( ftruncate(fd,d_size) < 0 ) {
+		int err = errno;
+		close(fd);
+		shm_unlink(d_name.c_str());
+		throw ARTEMIS_SYSTEM_ERROR(ftruncate,err);
+	}
+	auto mapped = mmap(nullptr,d_size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+	close(fd);
+	if ( mapped == MAP_FAILED ) {
+		int err = errno;
+		shm_unlink(d_name.c_str());
+		throw ARTEMIS_SYSTEM_ERROR(mmap,err);
+	}
+	d_mapped = reinterpret_cast<uint8_t*>(mapped);
+	d_data = d_mapped + HEADER_SIZE;
+
+	d_header = new (d_mapped) Header;
+	d_header->Version = VERSION;
+	d_header->Reserved0 = 0;
+	d_header->Capacity = dataSize;
+	d_header->Reserved.store(0);
+	d_header->Head.store(0);
+	d_header->Wakeup.store(0);
+	d_header->Waiters.store(0);
+	// consumers check the magic last.
+	std::atomic_thread_fence(std::memory_order_release);
+	d_header->Magic = MAGIC;
+
+	LOG(INFO) << "[SharedReadoutRing]: publishing readouts in '" << d_name
+	          << "' (" << dataSize << " bytes)";
+}
+
+SharedReadoutRing::~SharedReadoutRing() {
+	munmap(d_mapped,d_size);
+	shm_unlink(d_name.c_str());
+}
+
+size_t SharedReadoutRing::Capacity() const {
+	return d_header->Capacity;
+}
+
+const std::string & SharedReadoutRing::Name() const {
+	return d_name;
+}
+
+bool SharedReadoutRing::Publish(const google::protobuf::MessageLite & message, uint64_t frameID) {
+	using namespace google::protobuf::io;
+	size_t messageSize = message.ByteSizeLong();
+	size_t framedSize = CodedOutputStream::VarintSize32(messageSize) + messageSize;
+	size_t recordSize = RecordSize(framedSize);
+	const size_t capacity = d_header->Capacity;
+	if ( recordSize > capacity / 2 ) {
+		return false;
+	}
+
+	uint64_t head = d_header->Head.load(std::memory_order_relaxed);
+	size_t offset = head & (capacity - 1);
+	size_t toEnd = capacity - offset;
+	uint64_t end = head + recordSize + (toEnd < recordSize ? toEnd : 0);
+
+	// announces the overwritten area before touching it.
+	d_header->Reserved.store(end,std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	if ( toEnd < recordSize ) {
+		RecordHeader padding = {.Size = uint32_t(toEnd - sizeof(RecordHeader)),
+		                        .Flags = PADDING,
+		                        .FrameID = 0};
+		std::memcpy(d_data + offset,&padding,sizeof(padding));
+		offset = 0;
+	}
+
+	RecordHeader header = {.Size = uint32_t(framedSize), .Flags = 0, .FrameID = frameID};
+	auto record = d_data + offset;
+	std::memcpy(record,&header,sizeof(header));
+	auto data = CodedOutputStream::WriteVarint32ToArray(messageSize,record + sizeof(header));
+	message.SerializeWithCachedSizesToArray(data);
+
+	d_header->Head.store(end,std::memory_order_release);
+	d_header->Wakeup.fetch_add(1);
+	if ( d_header->Waiters.load() > 0 ) {
+		Futex(&d_header->Wakeup,FUTEX_WAKE,INT_MAX,nullptr);
+	}
+	return true;
+}
+
+
+SharedReadoutRing::Reader::Reader(const std::string & name)
+	: d_size(0)
+	, d_mapped(nullptr)
+	, d_header(nullptr)
+	, d_data(nullptr)
+	, d_position(0)
+	, d_overruns(0) {
+	auto segment = SegmentName(name);
+	// read-write, as readers register themselves as waiters.
+	int fd = shm_open(segment.c_str(),O_RDWR,0);
+	if ( fd < 0 ) {
+		throw std::system_error(errno,ARTEMIS_SYSTEM_CATEGORY(),"shm_open('" + segment + "')");
+	}
+	struct stat info;
+	if ( fstat(fd,&info) < 0 ) {
+		int err = errno;
+		close(fd);
+		throw ARTEMIS_SYSTEM_ERROR(fstat,err);
+	}
+	d_size = info.st_size;
+	if ( d_size < HEADER_SIZE ) {
+		close(fd);
+		throw std::runtime_error("'" + segment + "' is not a readout ring");
+	}
+	auto mapped = mmap(nullptr,d_size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+	close(fd);
+	if ( mapped == MAP_FAILED ) {
+		throw ARTEMIS_SYSTEM_ERROR(mmap,errno);
+	}
+	d_mapped = reinterpret_cast<uint8_t*>(mapped);
+	d_header = reinterpret_cast<Header*>(d_mapped);
+	d_data = d_mapped + HEADER_SIZE;
+	if ( d_header->Magic != MAGIC
+	     || d_header->Version != VERSION
+	     || HEADER_SIZE + d_header->Capacity != d_size ) {
+		munmap(d_mapped,d_size);
+		throw std::runtime_error("'" + segment + "' is not a readout ring");
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	d_position = d_header->Head.load(std::memory_order_acquire);
+}
+
+SharedReadoutRing::Reader::~Reader() {
+	munmap(d_mapped,d_size);
+}
+
+size_t SharedReadoutRing::Reader::Overruns() const {
+	return d_overruns;
+}
+
+bool SharedReadoutRing::Reader::Valid(uint64_t position) const {
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return d_header->Reserved.load(std::memory_order_relaxed) - position <= d_header->Capacity;
+}
+
+bool SharedReadoutRing::Reader::Wait(Duration timeout) {
+	auto deadline = Time::Now().Add(timeout);
+	for (;;) {
+		uint32_t wakeup = d_header->Wakeup.load();
+		if ( d_header->Head.load(std::memory_order_acquire) != d_position ) {
+			return true;
+		}
+		auto left = deadline.Sub(Time::Now());
+		if ( left <= 0 ) {
+			return false;
+		}
+		struct timespec ts = {.tv_sec = left.Nanoseconds() / 1000000000,
+		                      .tv_nsec = left.Nanoseconds() % 1000000000 };
+		d_header->Waiters.fetch_add(1);
+		// returns right away if a record was published since wakeup
+		// was read.
+		Futex(&d_header->Wakeup,FUTEX_WAIT,wakeup,&ts);
+		d_header->Waiters.fetch_sub(1);
+	}
+}
+
+SharedReadoutRing::Reader::Status
+SharedReadoutRing::Reader::Next(google::protobuf::MessageLite & message,
+                                uint64_t & frameID,
+                                Duration timeout) {
+	const size_t capacity = d_header->Capacity;
+	for (;;) {
+		if ( Wait(timeout) == false ) {
+			return Status::TIMEOUT;
+		}
+		uint64_t head = d_header->Head.load(std::memory_order_acquire);
+		if ( head - d_position > capacity ) {
+			// we are too late, continues with the next readout.
+			d_position = head;
+			++d_overruns;
+			return Status::OVERRUN;
+		}
+
+		size_t offset = d_position & (capacity - 1);
+		RecordHeader header;
+		std::memcpy(&header,d_data + offset,sizeof(header));
+		// a corrupted size must not read outside the data area.
+		size_t size = std::min(size_t(header.Size),capacity - offset - sizeof(header));
+
+		bool parsed = true;
+		if ( (header.Flags & PADDING) == 0 ) {
+			google::protobuf::io::CodedInputStream input(d_data + offset + sizeof(header),size);
+			parsed = google::protobuf::util::ParseDelimitedFromCodedStream(&message,&input,nullptr);
+		}
+		if ( Valid(d_position) == false ) {
+			d_position = d_header->Head.load(std::memory_order_acquire);
+			++d_overruns;
+			return Status::OVERRUN;
+		}
+		d_position += RecordSize(size);
+		if ( (header.Flags & PADDING) != 0 ) {
+			continue;
+		}
+		if ( parsed == false ) {
+			throw std::runtime_error("Could not parse readout from shared memory");
+		}
+		frameID = header.FrameID;
+		return Status::OK;
+	}
+}
+
+} // namespace artemis
+} // namespace fort
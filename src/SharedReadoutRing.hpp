@@ -0,0 +1,133 @@
+#pragma once
+
+#include <google/protobuf/message_lite.h>
+
+#include "Time.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace fort {
+namespace artemis {
+
+// Publishes readouts to co-located consumers through a ring in POSIX
+// shared memory, instead of a loopback socket.
+//
+// The segment starts with a HEADER_SIZE bytes Header, followed by a
+// data area of Capacity bytes, a power of two. Records are
+// RECORD_ALIGNMENT aligned and never wrap around the data area: a
+// RecordHeader followed by the readout with its hermes framing, the
+// varint size and the message bytes, so consumers can parse it in
+// place. A PADDING record fills the end of the area when the next
+// record does not fit.
+//
+// Positions are monotonic byte counts, taken modulo Capacity in the
+// data area. The single producer never waits: a consumer that falls
+// more than Capacity bytes behind is overrun. Reserved is advanced
+// before a record is written and Head once it is complete, so a
+// consumer detects, after reading a record at position p, that it
+// was overwritten meanwhile if Reserved - p > Capacity. Consumers
+// sleep on the Wakeup futex word, incremented for every record.
+class SharedReadoutRing {
+public:
+	typedef std::shared_ptr<SharedReadoutRing> Ptr;
+
+	const static size_t   HEADER_SIZE      = 4096;
+	const static size_t   RECORD_ALIGNMENT = 16;
+	const static size_t   DEFAULT_CAPACITY = 4 * 1024 * 1024;
+	// "ARTSHMRG" read as a little endian integer.
+	const static uint64_t MAGIC            = 0x47524d4853545241ULL;
+	const static uint32_t VERSION          = 1;
+	const static uint32_t PADDING          = 1;
+
+	struct Header {
+		uint64_t                          Magic;
+		uint32_t                          Version;
+		uint32_t                          Reserved0;
+		uint64_t                          Capacity;
+		alignas(64) std::atomic<uint64_t> Reserved;
+		alignas(64) std::atomic<uint64_t> Head;
+		alignas(64) std::atomic<uint32_t> Wakeup;
+		std::atomic<uint32_t>             Waiters;
+	};
+
+	struct RecordHeader {
+		// size of the framed readout following the header, or of the
+		// padding.
+		uint32_t Size;
+		uint32_t Flags;
+		uint64_t FrameID;
+	};
+
+	static_assert(sizeof(Header) <= HEADER_SIZE,"Header does not fit");
+	static_assert(sizeof(RecordHeader) == RECORD_ALIGNMENT,"Invalid record header size");
+	static_assert(std::atomic<uint32_t>::is_always_lock_free,"futex word must be lock free");
+
+	// Creates the segment name, replacing any previous one. capacity
+	// is rounded up to a power of two.
+	SharedReadoutRing(const std::string & name, size_t capacity = DEFAULT_CAPACITY);
+	// Unlinks the segment, consumers have to open the next one.
+	~SharedReadoutRing();
+
+	SharedReadoutRing(const SharedReadoutRing &) = delete;
+	SharedReadoutRing & operator=(const SharedReadoutRing &) = delete;
+
+	// Single producer only. Returns false if the readout is larger
+	// than half of the ring.
+	bool Publish(const google::protobuf::MessageLite & message, uint64_t frameID);
+
+	size_t Capacity() const;
+	const std::string & Name() const;
+
+	// Reads the readouts published after it opened the segment.
+	class Reader {
+	public:
+		enum class Status {
+			OK,
+			TIMEOUT,
+			// readouts were lost, the reader continues with the next
+			// published one.
+			OVERRUN,
+		};
+
+		Reader(const std::string & name);
+		~Reader();
+
+		Reader(const Reader &) = delete;
+		Reader & operator=(const Reader &) = delete;
+
+		// Waits up to timeout for the next readout, and parses it in
+		// place.
+		Status Next(google::protobuf::MessageLite & message,
+		            uint64_t & frameID,
+		            Duration timeout);
+
+		size_t Overruns() const;
+
+	private:
+		bool Valid(uint64_t position) const;
+		bool Wait(Duration timeout);
+
+		size_t          d_size;
+		uint8_t       * d_mapped;
+		Header        * d_header;
+		const uint8_t * d_data;
+		uint64_t        d_position;
+		size_t          d_overruns;
+	};
+
+	static std::string SegmentName(const std::string & name);
+
+private:
+	static size_t RecordSize(size_t size);
+
+	std::string d_name;
+	size_t      d_size;
+	uint8_t   * d_mapped;
+	Header    * d_header;
+	uint8_t   * d_data;
+};
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,94 @@
+#include "SharedReadoutRingUTest.hpp"
+
+#include "SharedReadoutRing.hpp"
+
+#include <fort/hermes/FrameReadout.pb.h>
+
+#include <limits>
+#include <thread>
+
+#include <unistd.h>
+
+namespace fort {
+namespace artemis {
+
+static std::string RingName() {
+	return "artemis-utest-" + std::to_string(getpid());
+}
+
+static hermes::FrameReadout Readout(uint64_t frameID) {
+	hermes::FrameReadout m;
+	m.set_frameid(frameID);
+	m.set_timestamp(20000 * frameID);
+	return m;
+}
+
+TEST_F(SharedReadoutRingUTest,ReadsInOrder) {
+	// small enough to wrap around several times.
+	SharedReadoutRing ring(RingName(),256);
+	SharedReadoutRing::Reader reader(RingName());
+
+	for ( uint64_t i = 1; i <= 100; ++i ) {
+		ASSERT_TRUE(ring.Publish(Readout(i),i));
+		hermes::FrameReadout m;
+		uint64_t frameID = 0;
+		ASSERT_EQ(reader.Next(m,frameID,Duration::Millisecond),
+		          SharedReadoutRing::Reader::Status::OK);
+		EXPECT_EQ(frameID,i);
+		EXPECT_EQ(m.frameid(),i);
+		EXPECT_EQ(m.timestamp(),20000 * i);
+	}
+
+	hermes::FrameReadout m;
+	uint64_t frameID;
+	EXPECT_EQ(reader.Next(m,frameID,Duration::Millisecond),
+	          SharedReadoutRing::Reader::Status::TIMEOUT);
+	EXPECT_EQ(reader.Overruns(),0);
+}
+
+TEST_F(SharedReadoutRingUTest,SlowReadersAreOverrun) {
+	SharedReadoutRing ring(RingName(),256);
+	SharedReadoutRing::Reader reader(RingName());
+
+	for ( uint64_t i = 1; i <= 100; ++i ) {
+		ASSERT_TRUE(ring.Publish(Readout(i),i));
+	}
+	hermes::FrameReadout m;
+	uint64_t frameID;
+	EXPECT_EQ(reader.Next(m,frameID,Duration::Millisecond),
+	          SharedReadoutRing::Reader::Status::OVERRUN);
+	EXPECT_EQ(reader.Overruns(),1);
+
+	// continues with the next readout.
+	ring.Publish(Readout(101),101);
+	ASSERT_EQ(reader.Next(m,frameID,Duration::Millisecond),
+	          SharedReadoutRing::Reader::Status::OK);
+	EXPECT_EQ(frameID,101);
+}
+
+TEST_F(SharedReadoutRingUTest,WakesUpReaders) {
+	SharedReadoutRing ring(RingName(),4096);
+	SharedReadoutRing::Reader reader(RingName());
+
+	std::thread producer([&ring]() {
+		                     std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		                     ring.Publish(Readout(42),42);
+	                     });
+	hermes::FrameReadout m;
+	uint64_t frameID = 0;
+	EXPECT_EQ(reader.Next(m,frameID,5 * Duration::Second),
+	          SharedReadoutRing::Reader::Status::OK);
+	EXPECT_EQ(frameID,42);
+	producer.join();
+}
+
+TEST_F(SharedReadoutRingUTest,RefusesLargeReadouts) {
+	SharedReadoutRing ring(RingName(),64);
+	hermes::FrameReadout m;
+	m.set_frameid(std::numeric_limits<uint64_t>::max());
+	m.set_timestamp(-1);
+	EXPECT_FALSE(ring.Publish(m,1));
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,81 @@
+#include "SpatialHash.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace fort {
+namespace artemis {
+
+SpatialHash::SpatialHash(double radius, size_t capacity)
+	: d_radius(std::max(radius,1.0))
+	, d_radiusSquared(d_radius * d_radius)
+	, d_generation(1) {
+	size_t slots = 16;
+	while ( slots < 2 * capacity ) {
+		slots *= 2;
+	}
+	d_slots.resize(slots,{0,-1});
+	d_entries.reserve(capacity);
+}
+
+void SpatialHash::Clear() {
+	d_entries.clear();
+	if ( ++d_generation != 0 ) {
+		return;
+	}
+	// generation wrapped around, we must actually reset the slots.
+	std::fill(d_slots.begin(),d_slots.end(),Slot{0,-1});
+	d_generation = 1;
+}
+
+int64_t SpatialHash::CellOf(double v) const {
+	return std::floor(v / d_radius);
+}
+
+size_t SpatialHash::SlotIndex(int64_t cx, int64_t cy) const {
+	uint64_t h = uint64_t(cx) * 73856093ULL ^ uint64_t(cy) * 19349663ULL;
+	return h & (d_slots.size() - 1);
+}
+
+void SpatialHash::Insert(uint32_t ID, double x, double y) {
+	auto & slot = d_slots[SlotIndex(CellOf(x),CellOf(y))];
+	if ( slot.Generation != d_generation ) {
+		slot = {d_generation,-1};
+	}
+	d_entries.push_back({ID,x,y,slot.First});
+	slot.First = d_entries.size() - 1;
+}
+
+bool SpatialHash::HasNeighbour(uint32_t ID, double x, double y) const {
+	int64_t cx = CellOf(x);
+	int64_t cy = CellOf(y);
+	for ( int64_t j = cy - 1; j <= cy + 1; ++j ) {
+		for ( int64_t i = cx - 1; i <= cx + 1; ++i ) {
+			const auto & slot = d_slots[SlotIndex(i,j)];
+			if ( slot.Generation != d_generation ) {
+				continue;
+			}
+			// different cells may share a slot, the distance test
+			// discards points of the other cells.
+			for ( int32_t e = slot.First; e >= 0; e = d_entries[e].Next ) {
+				const auto & entry = d_entries[e];
+				if ( entry.ID != ID ) {
+					continue;
+				}
+				double dx = entry.X - x;
+				double dy = entry.Y - y;
+				if ( dx * dx + dy * dy < d_radiusSquared ) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+size_t SpatialHash::Size() const {
+	return d_entries.size();
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace fort {
+namespace artemis {
+
+// Preallocated spatial hash of tag detections, used to find
+// duplicated detections of the same tag. Points are bucketed in cells
+// of the size of the search radius, so any point within the radius
+// lies in one of the 9 cells around a query. Clearing is O(1), and no
+// allocation happens as long as the number of points stays below the
+// reserved capacity.
+class SpatialHash {
+public:
+	// radius is at least one pixel.
+	SpatialHash(double radius, size_t capacity);
+
+	void Clear();
+
+	void Insert(uint32_t ID, double x, double y);
+
+	// Tests if a point with the same ID lies strictly within radius.
+	bool HasNeighbour(uint32_t ID, double x, double y) const;
+
+	size_t Size() const;
+
+private:
+	struct Slot {
+		uint32_t Generation;
+		int32_t  First;
+	};
+
+	struct Entry {
+		uint32_t ID;
+		double   X,Y;
+		int32_t  Next;
+	};
+
+	int64_t CellOf(double v) const;
+	size_t SlotIndex(int64_t cx, int64_t cy) const;
+
+	const double       d_radius,d_radiusSquared;
+	uint32_t           d_generation;
+	std::vector<Slot>  d_slots;
+	std::vector<Entry> d_entries;
+};
+
+} // namespace artemis
+} // namespace fort
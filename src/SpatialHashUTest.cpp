@@ -0,0 +1,50 @@
+#include "SpatialHashUTest.hpp"
+
+#include "SpatialHash.hpp"
+
+namespace fort {
+namespace artemis {
+
+TEST_F(SpatialHashUTest,FindsNeighbours) {
+	SpatialHash hash(5.0,4);
+
+	hash.Insert(1,100.0,100.0);
+	hash.Insert(2,103.0,100.0);
+	hash.Insert(1,-12.5,40.0);
+
+	EXPECT_TRUE(hash.HasNeighbour(1,100.0,100.0));
+	EXPECT_TRUE(hash.HasNeighbour(1,104.0,102.0));
+	EXPECT_TRUE(hash.HasNeighbour(1,-9.0,38.0));
+	EXPECT_TRUE(hash.HasNeighbour(2,100.0,100.0));
+	// outside of radius
+	EXPECT_FALSE(hash.HasNeighbour(1,105.0,100.0));
+	EXPECT_FALSE(hash.HasNeighbour(1,100.0,94.0));
+	// different ID
+	EXPECT_FALSE(hash.HasNeighbour(3,100.0,100.0));
+}
+
+TEST_F(SpatialHashUTest,CanBeCleared) {
+	SpatialHash hash(5.0,2);
+	for ( size_t i = 0; i < 3; ++i ) {
+		hash.Insert(1,10.0,10.0);
+		hash.Insert(2,20.0,10.0);
+		// exceeds the reserved capacity
+		hash.Insert(3,30.0,10.0);
+		EXPECT_EQ(hash.Size(),3);
+		EXPECT_TRUE(hash.HasNeighbour(3,30.0,10.0));
+		hash.Clear();
+		EXPECT_EQ(hash.Size(),0);
+		EXPECT_FALSE(hash.HasNeighbour(1,10.0,10.0));
+		EXPECT_FALSE(hash.HasNeighbour(3,30.0,10.0));
+	}
+}
+
+TEST_F(SpatialHashUTest,ClampsRadius) {
+	SpatialHash hash(0.5,2);
+	hash.Insert(1,10.0,10.0);
+	EXPECT_TRUE(hash.HasNeighbour(1,10.9,10.0));
+	EXPECT_FALSE(hash.HasNeighbour(1,11.0,10.0));
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+namespace fort {
+namespace artemis {
+
+class SpatialHashUTest : public ::testing::Test {
+};
+
+} // namespace artemis
+} // namespace fort
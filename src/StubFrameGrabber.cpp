@@ -11,9 +11,15 @@
 namespace fort {
 namespace artemis {
 
-StubFrame::StubFrame(const cv::Mat & mat, uint64_t ID)
-	: d_mat(mat.clone())
-	, d_ID(ID) {
+StubFrame::StubFrame()
+	: d_ID(0) {
+}
+
+void StubFrame::Reset(const cv::Mat & mat, uint64_t ID) {
+	// only the matrix header is copied, pixels are shared.
+	d_mat = mat;
+	d_ID = ID;
+	SetTime(fort::artemis::Time::Now());
 }
 
 StubFrame::~StubFrame() {}
@@ -82,7 +88,8 @@ Frame::Ptr StubFrameGrabber::NextFrame() {
 		usleep(toWait.Microseconds());
 	}
 
-	Frame::Ptr res = std::make_shared<StubFrame>(d_images[d_ID % d_images.size()],d_ID);
+	auto res = d_frames.Get();
+	res->Reset(d_images[d_ID % d_images.size()],d_ID);
 	d_ID += 1;
 	d_last = res->Time();
 	return res;
@@ -3,15 +3,20 @@
 #include <opencv2/core/core.hpp>
 
 #include "FrameGrabber.hpp"
+#include "ObjectPool.hpp"
 
 namespace fort {
 namespace artemis {
 
+// A frame sharing the grabber image buffer, which is never
+// modified. StubFrame are recycled by the grabber.
 class StubFrame : public Frame {
 public :
-	StubFrame(const cv::Mat & mat, uint64_t ID);
+	StubFrame();
 	virtual ~StubFrame();
 
+	void Reset(const cv::Mat & mat, uint64_t ID);
+
 
 	virtual void * Data();
 	virtual size_t Width() const;
@@ -41,6 +46,7 @@ private:
 	typedef std::chrono::high_resolution_clock clock;
 	typedef clock::time_point time;
 	std::vector<cv::Mat> d_images;
+	ObjectPool<StubFrame> d_frames;
 	uint64_t             d_ID,d_timestamp;
 	Time                 d_last;
 	Duration             d_period;
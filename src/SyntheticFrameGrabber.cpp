@@ -0,0 +1,228 @@
+#include "SyntheticFrameGrabber.hpp"
+
+#include "ApriltagDetector.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <unistd.h>
+
+#include <cmath>
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace fort {
+namespace artemis {
+
+SyntheticFrame::SyntheticFrame(const std::shared_ptr<cv::Mat> & mat,
+                               uint64_t ID,
+                               const std::vector<SyntheticTag> & tags)
+	: d_mat(mat)
+	, d_ID(ID)
+	, d_tags(tags) {
+}
+
+SyntheticFrame::~SyntheticFrame() {}
+
+void * SyntheticFrame::Data() {
+	return d_mat->data;
+}
+
+size_t SyntheticFrame::Width() const {
+	return d_mat->cols;
+}
+
+size_t SyntheticFrame::Height() const {
+	return d_mat->rows;
+}
+
+uint64_t SyntheticFrame::Timestamp() const {
+	return Time().MonotonicValue() / 1000;
+}
+
+uint64_t SyntheticFrame::ID() const {
+	return d_ID;
+}
+
+const cv::Mat & SyntheticFrame::ToCV() {
+	return *d_mat;
+}
+
+const std::vector<SyntheticTag> & SyntheticFrame::Tags() const {
+	return d_tags;
+}
+
+size_t SyntheticFrame::CountDetected(const hermes::FrameReadout & m,
+                                     double tolerance) const {
+	double squaredTolerance = tolerance * tolerance;
+	return std::count_if(d_tags.cbegin(),
+	                     d_tags.cend(),
+	                     [&](const SyntheticTag & truth) {
+		                     return std::any_of(m.tags().cbegin(),
+		                                        m.tags().cend(),
+		                                        [&](const auto & t) {
+			                                        double dx = t.x() - truth.X;
+			                                        double dy = t.y() - truth.Y;
+			                                        return t.id() == truth.ID
+				                                        && dx * dx + dy * dy <= squaredTolerance;
+		                                        });
+	                     });
+}
+
+
+SyntheticFrameGrabber::SyntheticFrameGrabber(const SyntheticOptions & options,
+                                             tags::Family family,
+                                             double FPS)
+	: d_tagSize(options.TagSize)
+	, d_motion(options.Motion)
+	, d_noise(options.Noise)
+	// a fixed seed, so benchmarks are reproducible.
+	, d_generator(0)
+	, d_ID(0)
+	, d_period(1.0e9 / FPS) {
+	if ( options.Tags == 0 ) {
+		throw std::invalid_argument("No tags to render in synthetic frames");
+	}
+	if ( options.Width == 0 || options.Height == 0 ) {
+		throw std::invalid_argument("Invalid synthetic frame size");
+	}
+
+	for ( size_t i = 0; i < BACKGROUNDS; ++i ) {
+		cv::Mat background(options.Height,options.Width,CV_8UC1);
+		cv::RNG rng(i);
+		rng.fill(background,cv::RNG::NORMAL,127.0,d_noise);
+		d_backgrounds.push_back(background);
+	}
+
+	auto f = ApriltagDetector::SharedFamily(family);
+	PlaceTags(options.Tags,f->ncodes);
+
+	for ( const auto & t : d_tags ) {
+		auto img = apriltag_to_image(const_cast<apriltag_family_t*>(f.get()),t.ID);
+		d_tagImages.push_back(cv::Mat(img->height,img->width,CV_8UC1,img->buf,img->stride).clone());
+		image_u8_destroy(img);
+	}
+
+	LOG(INFO) << "[SyntheticFrameGrabber]: rendering " << d_tags.size()
+	          << " tags in " << Resolution() << " frames";
+}
+
+SyntheticFrameGrabber::~SyntheticFrameGrabber() {
+}
+
+void SyntheticFrameGrabber::PlaceTags(size_t count, uint32_t ncodes) {
+	const auto & size = d_backgrounds.front().size();
+	size_t cols = std::ceil(std::sqrt(double(count * size.width) / double(size.height)));
+	size_t rows = (count + cols - 1) / cols;
+	double cellWidth = double(size.width) / cols;
+	double cellHeight = double(size.height) / rows;
+	// a tag center must stay far enough from its cell border, for any
+	// angle.
+	double halfDiagonal = d_tagSize * M_SQRT1_2 + 1.0;
+	if ( 2.0 * halfDiagonal > std::min(cellWidth,cellHeight) ) {
+		throw std::invalid_argument("Cannot fit " + std::to_string(count)
+		                            + " synthetic tags of " + std::to_string(size_t(d_tagSize))
+		                            + " pixels in the frame");
+	}
+
+	std::uniform_real_distribution<double> unit(0.0,1.0);
+	for ( size_t i = 0; i < count; ++i ) {
+		cv::Rect2d cell((i % cols) * cellWidth + halfDiagonal,
+		                (i / cols) * cellHeight + halfDiagonal,
+		                cellWidth - 2.0 * halfDiagonal,
+		                cellHeight - 2.0 * halfDiagonal);
+		d_tags.push_back({.ID = uint32_t(i % ncodes),
+		                  .X = cell.x + unit(d_generator) * cell.width,
+		                  .Y = cell.y + unit(d_generator) * cell.height,
+		                  .Angle = (2.0 * unit(d_generator) - 1.0) * M_PI,
+			});
+		// tags rotate with their corners moving at most as fast as
+		// their center.
+		d_placements.push_back({.Cell = cell,
+		                        .Direction = (2.0 * unit(d_generator) - 1.0) * M_PI,
+		                        .AngularSpeed = (2.0 * unit(d_generator) - 1.0) * d_motion / halfDiagonal,
+			});
+	}
+}
+
+void SyntheticFrameGrabber::MoveTags() {
+	if ( d_motion <= 0.0 ) {
+		return;
+	}
+	for ( size_t i = 0; i < d_tags.size(); ++i ) {
+		auto & t = d_tags[i];
+		auto & p = d_placements[i];
+		t.X += d_motion * std::cos(p.Direction);
+		t.Y += d_motion * std::sin(p.Direction);
+		// bounces on the cell borders
+		if ( t.X < p.Cell.x || t.X > p.Cell.x + p.Cell.width ) {
+			p.Direction = M_PI - p.Direction;
+			t.X = std::clamp(t.X,p.Cell.x,p.Cell.x + p.Cell.width);
+		}
+		if ( t.Y < p.Cell.y || t.Y > p.Cell.y + p.Cell.height ) {
+			p.Direction = -p.Direction;
+			t.Y = std::clamp(t.Y,p.Cell.y,p.Cell.y + p.Cell.height);
+		}
+		t.Angle = std::remainder(t.Angle + p.AngularSpeed,2.0 * M_PI);
+	}
+}
+
+void SyntheticFrameGrabber::RenderTag(cv::Mat & image, const SyntheticTag & tag,
+                                      const cv::Mat & tagImage) {
+	double half = d_tagSize * M_SQRT1_2 + 1.0;
+	cv::Rect roi(std::floor(tag.X - half),
+	             std::floor(tag.Y - half),
+	             std::ceil(2.0 * half) + 1,
+	             std::ceil(2.0 * half) + 1);
+	roi &= cv::Rect(cv::Point(0,0),image.size());
+
+	// rotates and scales around the tag image center, then moves it
+	// to the tag position. OpenCV angles are counter-clockwise on
+	// screen, ours are clockwise.
+	double center = (tagImage.cols - 1) / 2.0;
+	auto M = cv::getRotationMatrix2D(cv::Point2f(center,center),
+	                                 -tag.Angle * 180.0 / M_PI,
+	                                 d_tagSize / tagImage.cols);
+	M.at<double>(0,2) += tag.X - roi.x - center;
+	M.at<double>(1,2) += tag.Y - roi.y - center;
+
+	// the destination has the right size and type, so it is written
+	// in place, and left untouched outside of the tag.
+	cv::Mat destination = image(roi);
+	cv::warpAffine(tagImage,destination,M,roi.size(),
+	               cv::INTER_LINEAR,cv::BORDER_TRANSPARENT);
+}
+
+void SyntheticFrameGrabber::Start() {
+	d_last = Time::Now().Add(-d_period);
+}
+
+void SyntheticFrameGrabber::Stop() {
+}
+
+cv::Size SyntheticFrameGrabber::Resolution() const {
+	return d_backgrounds.front().size();
+}
+
+Frame::Ptr SyntheticFrameGrabber::NextFrame() {
+	auto toWait = d_last.Add(d_period).Sub(Time::Now());
+	if ( toWait > 0 ) {
+		usleep(toWait.Microseconds());
+	}
+
+	const auto & background = d_backgrounds[d_ID % d_backgrounds.size()];
+	auto image = d_images.Get(background.rows,background.cols,CV_8UC1);
+	background.copyTo(*image);
+	for ( size_t i = 0; i < d_tags.size(); ++i ) {
+		RenderTag(*image,d_tags[i],d_tagImages[i]);
+	}
+
+	auto res = std::make_shared<SyntheticFrame>(image,d_ID,d_tags);
+	MoveTags();
+	d_ID += 1;
+	d_last = res->Time();
+	return res;
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "FrameGrabber.hpp"
+#include "ObjectPool.hpp"
+#include "Options.hpp"
+
+#include <fort/hermes/FrameReadout.pb.h>
+
+#include <random>
+
+namespace fort {
+namespace artemis {
+
+// A tag rendered in a synthetic frame. Position is the tag center in
+// pixels, and angle follows ApriltagDetector conventions.
+struct SyntheticTag {
+	uint32_t ID;
+	double   X,Y,Angle;
+};
+
+class SyntheticFrame : public Frame {
+public :
+	SyntheticFrame(const std::shared_ptr<cv::Mat> & mat,
+	               uint64_t ID,
+	               const std::vector<SyntheticTag> & tags);
+	virtual ~SyntheticFrame();
+
+	virtual void * Data();
+	virtual size_t Width() const;
+	virtual size_t Height() const;
+	virtual uint64_t Timestamp() const;
+	virtual uint64_t ID() const;
+	const cv::Mat & ToCV();
+
+	// The ground truth of the frame.
+	const std::vector<SyntheticTag> & Tags() const;
+
+	// Number of tags of the ground truth found in m, within tolerance
+	// pixels of their actual position.
+	size_t CountDetected(const hermes::FrameReadout & m,
+	                     double tolerance) const;
+private :
+	std::shared_ptr<cv::Mat>  d_mat;
+	uint64_t                  d_ID;
+	std::vector<SyntheticTag> d_tags;
+};
+
+// Renders tags of a family at known positions and angles on a noisy
+// background. Each tag stays in its own cell of a regular grid, so
+// they never overlap, and moves by a fixed distance every frame.
+class SyntheticFrameGrabber : public FrameGrabber {
+public :
+	SyntheticFrameGrabber(const SyntheticOptions & options,
+	                      tags::Family family,
+	                      double FPS);
+
+	virtual ~SyntheticFrameGrabber();
+
+	void Start() override;
+	void Stop() override;
+	Frame::Ptr NextFrame() override;
+
+	cv::Size Resolution() const override;
+private:
+	struct Placement {
+		cv::Rect2d Cell;
+		double     Direction;
+		double     AngularSpeed;
+	};
+
+	void PlaceTags(size_t count, uint32_t ncodes);
+
+	void MoveTags();
+
+	void RenderTag(cv::Mat & image,
+	               const SyntheticTag & tag,
+	               const cv::Mat & tagImage);
+
+	const static size_t BACKGROUNDS = 4;
+
+	const double              d_tagSize;
+	const double              d_motion;
+	const double              d_noise;
+	std::vector<cv::Mat>      d_tagImages;
+	std::vector<cv::Mat>      d_backgrounds;
+	std::vector<SyntheticTag> d_tags;
+	std::vector<Placement>    d_placements;
+	ObjectPool<cv::Mat>       d_images;
+	std::mt19937              d_generator;
+	uint64_t                  d_ID;
+	Time                      d_last;
+	Duration                  d_period;
+};
+
+
+} // namespace artemis
+} // namespace fort
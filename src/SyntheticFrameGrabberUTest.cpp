@@ -0,0 +1,54 @@
+#include "SyntheticFrameGrabberUTest.hpp"
+
+#include "SyntheticFrameGrabber.hpp"
+#include "ApriltagDetector.hpp"
+
+#include <tbb/task_arena.h>
+
+namespace fort {
+namespace artemis {
+
+TEST_F(SyntheticFrameGrabberUTest,RendersDetectableTags) {
+	SyntheticOptions options;
+	options.Tags = 12;
+	options.TagSize = 60;
+	options.Width = 800;
+	options.Height = 600;
+	options.Motion = 4.0;
+
+	ApriltagOptions atOptions;
+	atOptions.Family = tags::Family::Tag36h11;
+
+	SyntheticFrameGrabber grabber(options,atOptions.Family,1000.0);
+	EXPECT_EQ(grabber.Resolution(),cv::Size(800,600));
+	ApriltagDetector detector(2,grabber.Resolution(),atOptions);
+	tbb::task_arena arena(2);
+
+	grabber.Start();
+	for ( uint64_t i = 0; i < 3; ++i ) {
+		auto frame = std::dynamic_pointer_cast<SyntheticFrame>(grabber.NextFrame());
+		ASSERT_TRUE(frame);
+		EXPECT_EQ(frame->ID(),i);
+		ASSERT_EQ(frame->Tags().size(),12);
+		for ( const auto & t : frame->Tags() ) {
+			EXPECT_TRUE(t.X >= 0 && t.X < 800 && t.Y >= 0 && t.Y < 600);
+		}
+
+		hermes::FrameReadout m;
+		arena.execute([&]() { detector.Detect(frame->ToCV(),m); });
+		EXPECT_EQ(frame->CountDetected(m,3.0),12);
+	}
+}
+
+TEST_F(SyntheticFrameGrabberUTest,RejectsTooManyTags) {
+	SyntheticOptions options;
+	options.Tags = 1000;
+	options.TagSize = 100;
+	options.Width = 800;
+	options.Height = 600;
+	EXPECT_THROW(SyntheticFrameGrabber(options,tags::Family::Tag36h11,8.0),
+	             std::invalid_argument);
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+namespace fort {
+namespace artemis {
+
+class SyntheticFrameGrabberUTest : public ::testing::Test {
+};
+
+
+} // namespace artemis
+} // namespace fort
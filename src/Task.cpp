@@ -6,16 +6,43 @@
 #include <sys/resource.h>
 
 #include "utils/PosixCall.hpp"
+#include "utils/RealTime.hpp"
+#include "ThreadPlacement.hpp"
+
+#include <glog/logging.h>
 
 
 namespace fort {
 namespace artemis {
 
+// stack prefaulted by real-time threads.
+const static size_t REAL_TIME_STACK_SIZE = 256 * 1024;
+
 Task::~Task() {}
 
-std::thread Task::Spawn(Task & task,size_t niceness) {
-	return std::thread([&task,niceness]() {
-		                   if ( niceness != 0 ) {
+std::thread Task::Spawn(Task & task,
+                        size_t niceness,
+                        const std::vector<size_t> & cpus,
+                        const RealTime & realTime) {
+	return std::thread([&task,niceness,cpus,realTime]() {
+		                   try {
+			                   ThreadPlacement::PinCurrentThread(cpus);
+		                   } catch ( const std::exception & e ) {
+			                   LOG(WARNING) << "Could not pin task thread: " << e.what();
+		                   }
+		                   bool isRealTime = false;
+		                   if ( realTime.Priority > 0 ) {
+			                   try {
+				                   SetRealTimeScheduling(realTime.Policy,realTime.Priority);
+				                   PrefaultStack(REAL_TIME_STACK_SIZE);
+				                   isRealTime = true;
+			                   } catch ( const std::system_error & e ) {
+				                   LOG(WARNING) << "Could not use real-time priority "
+				                                << realTime.Priority << ", using normal scheduling: "
+				                                << e.what();
+			                   }
+		                   }
+		                   if ( isRealTime == false && niceness != 0 ) {
 			                   auto tid = syscall(SYS_gettid);
 			                   p_call(setpriority,PRIO_PROCESS,tid,niceness);
 		                   }
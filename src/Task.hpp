@@ -1,6 +1,7 @@
 #pragma once
 
 #include <thread>
+#include <vector>
 
 namespace fort {
 namespace artemis {
@@ -11,7 +12,20 @@ public:
 
 	virtual void Run() = 0;
 
-	static std::thread Spawn(Task & task,size_t niceness);
+	// Real-time scheduling of a task thread. A zero priority, as
+	// when value-initialized, keeps the normal scheduling.
+	struct RealTime {
+		int Policy;
+		int Priority;
+	};
+
+	// The task thread is pinned to cpus, unless it is empty. If the
+	// real-time scheduling cannot be set, it falls back to the
+	// niceness.
+	static std::thread Spawn(Task & task,
+	                         size_t niceness,
+	                         const std::vector<size_t> & cpus = {},
+	                         const RealTime & realTime = {});
 };
 
 } // namespace artemis
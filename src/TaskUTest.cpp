@@ -2,8 +2,14 @@
 
 #include "Task.hpp"
 
+#include "utils/RealTime.hpp"
+
+#include <sched.h>
+#include <sys/resource.h>
 #include <unistd.h>
 
+#include <system_error>
+
 namespace fort {
 namespace artemis {
 
@@ -26,5 +32,40 @@ TEST_F(TaskUTest,Niceness) {
 
 }
 
+class SchedulingTask : public Task {
+public:
+	virtual ~SchedulingTask() {}
+
+	void Run() override {
+		Policy = sched_getscheduler(0);
+		Niceness = getpriority(PRIO_PROCESS,0);
+	}
+
+	int Policy = -1;
+	int Niceness = -1;
+};
+
+TEST_F(TaskUTest,RealTimeFallsBack) {
+	// runs whether or not we are allowed to use real-time scheduling.
+	bool allowed = true;
+	std::thread([&allowed]() {
+		            try {
+			            SetRealTimeScheduling(SCHED_FIFO,10);
+		            } catch ( const std::system_error & ) {
+			            allowed = false;
+		            }
+	            }).join();
+
+	SchedulingTask t;
+	auto th = Task::Spawn(t,1,{},{.Policy = SCHED_FIFO, .Priority = 10});
+	th.join();
+	if ( allowed == true ) {
+		EXPECT_EQ(t.Policy,SCHED_FIFO);
+	} else {
+		EXPECT_EQ(t.Policy,SCHED_OTHER);
+		EXPECT_EQ(t.Niceness,1);
+	}
+}
+
 } // namespace artemis
 } // namespace fort
@@ -0,0 +1,61 @@
+#include "ThreadBudget.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace fort {
+namespace artemis {
+
+ThreadBudget::ThreadBudget(size_t total)
+	: d_total(std::max(total,size_t(1)))
+	// a thread is set aside for the background only when detection
+	// keeps at least two.
+	, d_background(d_total > 2 ? 1 : 0)
+	, d_detection(int(d_total - d_background))
+	, d_cataloguing(int(d_background + 1))
+	// a single thread encodes full frames, with no help.
+	, d_export(1) {
+}
+
+size_t ThreadBudget::Total() const {
+	return d_total;
+}
+
+size_t ThreadBudget::DetectionThreads() const {
+	return d_total - d_background;
+}
+
+size_t ThreadBudget::BackgroundThreads() const {
+	return d_background;
+}
+
+tbb::task_arena & ThreadBudget::Detection() {
+	return d_detection;
+}
+
+tbb::task_arena & ThreadBudget::Cataloguing() {
+	return d_cataloguing;
+}
+
+tbb::task_arena & ThreadBudget::Export() {
+	return d_export;
+}
+
+void ThreadBudget::PinWorkers(const ThreadPlacement & placement) {
+	typedef ThreadPlacement::Role Role;
+	d_pinnings.clear();
+	d_pinnings.push_back(placement.PinArenaWorkers(d_detection,Role::Detection));
+	d_pinnings.push_back(placement.PinArenaWorkers(d_cataloguing,Role::Background));
+	d_pinnings.push_back(placement.PinArenaWorkers(d_export,Role::Background));
+}
+
+size_t ThreadBudget::DefaultTotal() {
+	size_t cores = std::thread::hardware_concurrency();
+	if ( cores <= 2 ) {
+		return 1;
+	}
+	return cores - 2;
+}
+
+} // namespace artemis
+} // namespace fort
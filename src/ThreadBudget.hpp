@@ -0,0 +1,57 @@
+#pragma once
+
+#include <tbb/task_arena.h>
+
+#include "ThreadPlacement.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace fort {
+namespace artemis {
+
+// Splits the computation threads between detection and the
+// background work, ant cataloguing and full frame export, each with
+// its own TBB arena. All cameras share the detection arena, so a busy
+// camera can use the threads an idle one leaves, as cameras only enter
+// it while they have frames to process. Work executed in an arena
+// never uses more threads than the arena allows, so background PNG
+// encoding cannot take threads away from detection. OpenCV parallel regions do not follow the arenas, as
+// OpenCV keeps its own: they are only bound by cv::setNumThreads.
+class ThreadBudget {
+public:
+	typedef std::shared_ptr<ThreadBudget> Ptr;
+
+	// total is the number of threads available for computation.
+	ThreadBudget(size_t total);
+
+	size_t Total() const;
+	size_t DetectionThreads() const;
+	// Threads reserved to cataloguing, in addition to the thread
+	// that requests it.
+	size_t BackgroundThreads() const;
+
+	tbb::task_arena & Detection();
+	tbb::task_arena & Cataloguing();
+	tbb::task_arena & Export();
+
+	// Pins the workers of the detection arena to the detection CPUs,
+	// and the ones of the background arenas to the background CPUs.
+	// Must be called before any work runs in the arenas.
+	void PinWorkers(const ThreadPlacement & placement);
+
+	// Leaves two cores of the host to acquisition, display and IO.
+	static size_t DefaultTotal();
+
+private:
+	const size_t    d_total;
+	const size_t    d_background;
+	tbb::task_arena d_detection;
+	tbb::task_arena d_cataloguing;
+	tbb::task_arena d_export;
+	// released before the arenas they observe.
+	std::vector<ThreadPlacement::WorkerPinning> d_pinnings;
+};
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,74 @@
+#include "ThreadBudgetUTest.hpp"
+
+#include "ThreadBudget.hpp"
+
+#include <tbb/parallel_for.h>
+#include <tbb/enumerable_thread_specific.h>
+
+#include <chrono>
+#include <thread>
+
+namespace fort {
+namespace artemis {
+
+TEST_F(ThreadBudgetUTest,SplitsThreads) {
+	struct TestData {
+		size_t Total,Detection,Background;
+	};
+	std::vector<TestData> testdata = {
+		{0,1,0},
+		{1,1,0},
+		{2,2,0},
+		{3,2,1},
+		{8,7,1},
+	};
+	for ( const auto & d : testdata ) {
+		ThreadBudget budget(d.Total);
+		EXPECT_EQ(budget.DetectionThreads(),d.Detection) << "total: " << d.Total;
+		EXPECT_EQ(budget.BackgroundThreads(),d.Background) << "total: " << d.Total;
+		EXPECT_EQ(budget.Total(),d.Detection + d.Background);
+		EXPECT_EQ(budget.Detection().max_concurrency(),d.Detection);
+		EXPECT_EQ(budget.Cataloguing().max_concurrency(),d.Background + 1);
+		EXPECT_EQ(budget.Export().max_concurrency(),1);
+	}
+	EXPECT_GE(ThreadBudget::DefaultTotal(),1);
+}
+
+TEST_F(ThreadBudgetUTest,SharesDetectionBetweenCameras) {
+	ThreadBudget budget(3);
+	tbb::enumerable_thread_specific<size_t> used(0);
+	// each camera runs its detection in the same arena.
+	auto camera = [&]() {
+		              budget.Detection().execute([&]() {
+			              tbb::parallel_for(size_t(0),size_t(1000),[&](size_t) {
+				              ++used.local();
+				              std::this_thread::sleep_for(std::chrono::microseconds(10));
+			              });
+		              });
+	              };
+	std::thread first(camera),second(camera);
+	first.join();
+	second.join();
+	EXPECT_LE(used.size(),budget.DetectionThreads());
+	size_t total = 0;
+	for ( const auto & count : used ) {
+		total += count;
+	}
+	EXPECT_EQ(total,2000);
+}
+
+TEST_F(ThreadBudgetUTest,LimitsConcurrency) {
+	ThreadBudget budget(3);
+	tbb::enumerable_thread_specific<size_t> used(0);
+	budget.Detection().execute([&]() {
+		tbb::parallel_for(size_t(0),size_t(1000),[&](size_t) {
+			++used.local();
+			// gives other threads a chance to join.
+			std::this_thread::sleep_for(std::chrono::microseconds(10));
+		});
+	});
+	EXPECT_LE(used.size(),budget.DetectionThreads());
+}
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,213 @@
+#include "ThreadPlacement.hpp"
+
+#include "Options.hpp"
+#include "utils/PosixCall.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include <glog/logging.h>
+
+namespace fort {
+namespace artemis {
+
+class ThreadPlacement::WorkerObserver : public tbb::task_scheduler_observer {
+public:
+	WorkerObserver(tbb::task_arena & arena, const CPUSet & cpus)
+		: tbb::task_scheduler_observer(arena)
+		, d_cpus(cpus) {
+		observe(true);
+	}
+
+	virtual ~WorkerObserver() {
+		observe(false);
+	}
+
+	void on_scheduler_entry(bool isWorker) override {
+		if ( isWorker == false ) {
+			return;
+		}
+		try {
+			PinCurrentThread(d_cpus);
+		} catch ( const std::exception & e ) {
+			LOG(WARNING) << "[ThreadPlacement]: could not pin TBB worker: " << e.what();
+		}
+	}
+
+private:
+	const CPUSet d_cpus;
+};
+
+ThreadPlacement::ThreadPlacement()
+	: d_cpus(size_t(Role::NB_ROLES)) {
+}
+
+ThreadPlacement::ThreadPlacement(const std::vector<Core> & cores,
+                                 const PlacementOptions & options,
+                                 size_t acquisitionThreads)
+	: d_cpus(size_t(Role::NB_ROLES)) {
+	if ( options.Disabled == true ) {
+		return;
+	}
+	SetUpAutomatic(cores,options.Package,std::max(acquisitionThreads,size_t(1)));
+
+	auto acquisition = ParseCPUList(options.AcquisitionCPUs);
+	if ( acquisition.empty() == false ) {
+		d_cpus[size_t(Role::Acquisition)] = acquisition;
+	}
+	auto detection = ParseCPUList(options.DetectionCPUs);
+	if ( detection.empty() == false ) {
+		d_cpus[size_t(Role::Processing)] = detection;
+		d_cpus[size_t(Role::Detection)] = detection;
+	}
+	auto service = ParseCPUList(options.ServiceCPUs);
+	if ( service.empty() == false ) {
+		for ( auto role : {Role::IO,Role::VideoOutput,Role::UserInterface,Role::Background} ) {
+			d_cpus[size_t(role)] = service;
+		}
+	}
+}
+
+ThreadPlacement::~ThreadPlacement() {}
+
+void ThreadPlacement::SetUpAutomatic(const std::vector<Core> & cores,
+                                     PackageID package,
+                                     size_t acquisitionThreads) {
+	std::vector<Core> local,remote;
+	for ( const auto & core : cores ) {
+		if ( core.Package == package ) {
+			local.push_back(core);
+		} else {
+			remote.push_back(core);
+		}
+	}
+	if ( local.empty() == true && cores.empty() == false ) {
+		LOG(WARNING) << "[ThreadPlacement]: no package " << package
+		             << ", using package " << cores.front().Package;
+		SetUpAutomatic(cores,cores.front().Package,acquisitionThreads);
+		return;
+	}
+
+	// detection needs at least one core, and service threads one
+	// more if there is no other package.
+	size_t needed = acquisitionThreads + (remote.empty() ? 2 : 1);
+	if ( local.size() < needed ) {
+		return;
+	}
+
+	CPUSet acquisition,detection,service;
+	for ( size_t i = 0; i < acquisitionThreads; ++i ) {
+		acquisition.push_back(local[i].CPUs.front());
+	}
+	size_t detectionEnd = remote.empty() ? local.size() - 1 : local.size();
+	for ( size_t i = acquisitionThreads; i < detectionEnd; ++i ) {
+		detection.insert(detection.end(),local[i].CPUs.begin(),local[i].CPUs.end());
+	}
+	const auto & serviceCores = remote.empty() ? std::vector<Core>(1,local.back()) : remote;
+	for ( const auto & core : serviceCores ) {
+		service.insert(service.end(),core.CPUs.begin(),core.CPUs.end());
+	}
+	std::sort(service.begin(),service.end());
+
+	d_cpus[size_t(Role::Acquisition)] = acquisition;
+	d_cpus[size_t(Role::Processing)] = detection;
+	d_cpus[size_t(Role::Detection)] = detection;
+	for ( auto role : {Role::IO,Role::VideoOutput,Role::UserInterface,Role::Background} ) {
+		d_cpus[size_t(role)] = service;
+	}
+}
+
+const ThreadPlacement::CPUSet & ThreadPlacement::CPUs(Role role) const {
+	return d_cpus[size_t(role)];
+}
+
+ThreadPlacement::WorkerPinning ThreadPlacement::PinArenaWorkers(tbb::task_arena & arena,
+                                                                Role role) const {
+	const auto & cpus = CPUs(role);
+	if ( cpus.empty() == true ) {
+		return WorkerPinning();
+	}
+	return std::make_unique<WorkerObserver>(arena,cpus);
+}
+
+std::string ThreadPlacement::Describe() const {
+	const static std::vector<std::string> names = {
+		"acquisition",
+		"processing",
+		"detection",
+		"IO",
+		"video output",
+		"user interface",
+		"background",
+	};
+	std::ostringstream oss;
+	std::string prefix;
+	for ( size_t i = 0; i < d_cpus.size(); ++i ) {
+		oss << prefix << names[i] << ": ";
+		prefix = ", ";
+		if ( d_cpus[i].empty() ) {
+			oss << "any";
+			continue;
+		}
+		std::string sep;
+		for ( auto cpu : d_cpus[i] ) {
+			oss << sep << cpu;
+			sep = " ";
+		}
+	}
+	return oss.str();
+}
+
+ThreadPlacement::CPUSet ThreadPlacement::ParseCPUList(const std::string & list) {
+	CPUSet res;
+	std::istringstream iss(list);
+	for ( std::string range; std::getline(iss,range,','); ) {
+		if ( range.empty() ) {
+			continue;
+		}
+		size_t first,last;
+		char dash;
+		std::istringstream rs(range);
+		rs >> first;
+		last = first;
+		if ( rs.fail() == false && rs.eof() == false ) {
+			rs >> dash >> last;
+			if ( dash != '-' ) {
+				rs.setstate(std::ios::failbit);
+			}
+		}
+		if ( rs.fail() || (rs >> std::ws).eof() == false || last < first ) {
+			throw std::invalid_argument("Invalid CPU list '" + list + "'");
+		}
+		for ( size_t cpu = first; cpu <= last; ++cpu ) {
+			res.push_back(cpu);
+		}
+	}
+	std::sort(res.begin(),res.end());
+	res.erase(std::unique(res.begin(),res.end()),res.end());
+	return res;
+}
+
+void ThreadPlacement::PinCurrentThread(const CPUSet & cpus) {
+	if ( cpus.empty() == true ) {
+		return;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for ( auto cpu : cpus ) {
+		if ( cpu >= CPU_SETSIZE ) {
+			throw std::out_of_range("CPU " + std::to_string(cpu) + " is out of range");
+		}
+		CPU_SET(cpu,&set);
+	}
+	int err = pthread_setaffinity_np(pthread_self(),sizeof(set),&set);
+	if ( err != 0 ) {
+		throw ARTEMIS_SYSTEM_ERROR(pthread_setaffinity_np,err);
+	}
+}
+
+} // namespace artemis
+} // namespace fort
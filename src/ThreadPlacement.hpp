@@ -0,0 +1,80 @@
+#pragma once
+
+#include "utils/CPUMap.hpp"
+
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fort {
+namespace artemis {
+
+struct PlacementOptions;
+
+// Chooses the CPUs each kind of thread runs on. The automatic
+// placement keeps acquisition and detection on a single package, the
+// one the framegrabber is attached to: each acquisition thread gets
+// one logical CPU of its own core, whose SMT siblings are left idle,
+// and detection gets all the other cores but one. IO, video output,
+// user interface and background tasks use the other packages, or the
+// remaining core on single package hosts.
+class ThreadPlacement {
+public:
+	typedef std::vector<CPUID> CPUSet;
+
+	enum class Role {
+		Acquisition = 0,
+		// the processing thread also runs detection tasks.
+		Processing,
+		Detection,
+		IO,
+		VideoOutput,
+		UserInterface,
+		// PNG encoding and raw frame recording.
+		Background,
+		NB_ROLES,
+	};
+
+	// No thread is pinned.
+	ThreadPlacement();
+
+	ThreadPlacement(const std::vector<Core> & cores,
+	                const PlacementOptions & options,
+	                size_t acquisitionThreads);
+
+	~ThreadPlacement();
+
+	// An empty set means the thread is not pinned.
+	const CPUSet & CPUs(Role role) const;
+
+	typedef std::unique_ptr<tbb::task_scheduler_observer> WorkerPinning;
+
+	// Pins the TBB worker threads joining arena to the CPUs of role,
+	// as long as the returned observer lives. It must be created
+	// before any work runs in the arena, and must not outlive
+	// it. Returns an empty pointer if role is not pinned.
+	WorkerPinning PinArenaWorkers(tbb::task_arena & arena, Role role) const;
+
+	std::string Describe() const;
+
+	// Parses a list like "0,2-5".
+	static CPUSet ParseCPUList(const std::string & list);
+
+	// Does nothing for an empty set.
+	static void PinCurrentThread(const CPUSet & cpus);
+
+private:
+	class WorkerObserver;
+
+	void SetUpAutomatic(const std::vector<Core> & cores,
+	                    PackageID package,
+	                    size_t acquisitionThreads);
+
+	std::vector<CPUSet>             d_cpus;
+};
+
+} // namespace artemis
+} // namespace fort
@@ -0,0 +1,141 @@
+#include "ThreadPlacementUTest.hpp"
+
+#include "ThreadPlacement.hpp"
+#include "Options.hpp"
+
+#include <sched.h>
+
+#include <tbb/parallel_for.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace fort {
+namespace artemis {
+
+typedef ThreadPlacement::Role Role;
+typedef ThreadPlacement::CPUSet CPUSet;
+
+// cores with two SMT siblings, numbered like Linux does: siblings are
+// offset by the total number of cores.
+std::vector<Core> MakeCores(size_t packages, size_t coresPerPackage) {
+	std::vector<Core> res;
+	size_t total = packages * coresPerPackage;
+	for ( size_t p = 0; p < packages; ++p ) {
+		for ( size_t c = 0; c < coresPerPackage; ++c ) {
+			size_t cpu = p * coresPerPackage + c;
+			res.push_back(Core{.ID = c, .Package = p, .CPUs = {cpu,cpu + total}});
+		}
+	}
+	return res;
+}
+
+TEST_F(ThreadPlacementUTest,SinglePackage) {
+	ThreadPlacement placement(MakeCores(1,4),PlacementOptions(),1);
+	EXPECT_EQ(placement.CPUs(Role::Acquisition),CPUSet({0}));
+	// the sibling of the acquisition CPU, 4, is left idle.
+	EXPECT_EQ(placement.CPUs(Role::Detection),CPUSet({1,5,2,6}));
+	EXPECT_EQ(placement.CPUs(Role::Processing),CPUSet({1,5,2,6}));
+	EXPECT_EQ(placement.CPUs(Role::IO),CPUSet({3,7}));
+	EXPECT_EQ(placement.CPUs(Role::UserInterface),CPUSet({3,7}));
+	EXPECT_EQ(placement.CPUs(Role::Background),CPUSet({3,7}));
+}
+
+TEST_F(ThreadPlacementUTest,DualPackage) {
+	PlacementOptions options;
+	options.Package = 1;
+	ThreadPlacement placement(MakeCores(2,4),options,2);
+	EXPECT_EQ(placement.CPUs(Role::Acquisition),CPUSet({4,5}));
+	EXPECT_EQ(placement.CPUs(Role::Detection),CPUSet({6,14,7,15}));
+	EXPECT_EQ(placement.CPUs(Role::VideoOutput),CPUSet({0,1,2,3,8,9,10,11}));
+}
+
+TEST_F(ThreadPlacementUTest,NoPinning) {
+	PlacementOptions options;
+	options.Disabled = true;
+	ThreadPlacement disabled(MakeCores(1,8),options,1);
+	// too few cores to isolate acquisition.
+	ThreadPlacement small(MakeCores(1,2),PlacementOptions(),1);
+	for ( size_t i = 0; i < size_t(Role::NB_ROLES); ++i ) {
+		EXPECT_TRUE(disabled.CPUs(Role(i)).empty());
+		EXPECT_TRUE(small.CPUs(Role(i)).empty());
+	}
+}
+
+TEST_F(ThreadPlacementUTest,ManualOverride) {
+	PlacementOptions options;
+	options.AcquisitionCPUs = "3";
+	options.DetectionCPUs = "4-6,0";
+	ThreadPlacement placement(MakeCores(1,8),options,1);
+	EXPECT_EQ(placement.CPUs(Role::Acquisition),CPUSet({3}));
+	EXPECT_EQ(placement.CPUs(Role::Detection),CPUSet({0,4,5,6}));
+	EXPECT_EQ(placement.CPUs(Role::Processing),CPUSet({0,4,5,6}));
+	EXPECT_EQ(placement.CPUs(Role::IO),CPUSet({7,15}));
+}
+
+TEST_F(ThreadPlacementUTest,ParsesCPUList) {
+	EXPECT_EQ(ThreadPlacement::ParseCPUList(""),CPUSet());
+	EXPECT_EQ(ThreadPlacement::ParseCPUList("2"),CPUSet({2}));
+	EXPECT_EQ(ThreadPlacement::ParseCPUList("5,1-3,2"),CPUSet({1,2,3,5}));
+	for ( const auto & invalid : {"a","1-","3-1","1;2","1-2-3"} ) {
+		EXPECT_THROW({ThreadPlacement::ParseCPUList(invalid);},std::invalid_argument) << invalid;
+	}
+}
+
+TEST_F(ThreadPlacementUTest,PinsCurrentThread) {
+	EXPECT_NO_THROW(ThreadPlacement::PinCurrentThread({}));
+	// the test may not be allowed on all CPUs.
+	cpu_set_t allowed;
+	ASSERT_EQ(sched_getaffinity(0,sizeof(allowed),&allowed),0);
+	size_t cpu = 0;
+	while ( CPU_ISSET(cpu,&allowed) == 0 ) {
+		++cpu;
+	}
+	std::thread t([cpu]() {
+		EXPECT_NO_THROW(ThreadPlacement::PinCurrentThread({cpu}));
+		EXPECT_EQ(sched_getcpu(),cpu);
+	});
+	t.join();
+}
+
+TEST_F(ThreadPlacementUTest,PinsArenaWorkers) {
+	cpu_set_t allowed;
+	ASSERT_EQ(sched_getaffinity(0,sizeof(allowed),&allowed),0);
+	size_t cpu = 0;
+	while ( CPU_ISSET(cpu,&allowed) == 0 ) {
+		++cpu;
+	}
+	PlacementOptions options;
+	options.DetectionCPUs = std::to_string(cpu);
+	ThreadPlacement placement(MakeCores(1,4),options,1);
+
+	tbb::task_arena arena(3);
+	auto pinning = placement.PinArenaWorkers(arena,Role::Detection);
+	ASSERT_TRUE(pinning);
+	EXPECT_FALSE(ThreadPlacement().PinArenaWorkers(arena,Role::Detection));
+
+	auto caller = std::this_thread::get_id();
+	std::atomic<size_t> workers(0),pinned(0);
+	arena.execute([&]() {
+		tbb::parallel_for(0,200,[&](int) {
+			if ( std::this_thread::get_id() != caller ) {
+				cpu_set_t set;
+				sched_getaffinity(0,sizeof(set),&set);
+				++workers;
+				if ( CPU_COUNT(&set) == 1 && CPU_ISSET(cpu,&set) ) {
+					++pinned;
+				}
+			}
+			// gives workers a chance to join.
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		});
+	});
+	if ( std::thread::hardware_concurrency() > 1 ) {
+		EXPECT_GT(workers.load(),0);
+	}
+	EXPECT_EQ(pinned.load(),workers.load());
+}
+
+} // namespace artemis
+} // namespace fort
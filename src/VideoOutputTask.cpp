@@ -8,17 +8,20 @@
 #include <boost/asio/buffer.hpp>
 
 #include "ImageTextRenderer.hpp"
+#include "LossLedger.hpp"
 
 namespace fort {
 namespace artemis {
 
 VideoOutputTask::VideoOutputTask(const VideoOutputOptions & options,
                                  boost::asio::io_context & context,
-                                 bool legacyMode)
+                                 bool legacyMode,
+                                 const LossLedgerPtr & lossLedger)
 	: d_stream(context,STDOUT_FILENO)
 	, d_done(true)
 	, d_addHeader(options.AddHeader)
-	, d_legacyMode(legacyMode) {
+	, d_legacyMode(legacyMode)
+	, d_lossLedger(lossLedger) {
 
 	int flags = fcntl(STDOUT_FILENO, F_GETFL);
 	if ( flags == -1 ) {
@@ -64,6 +67,9 @@ void VideoOutputTask::Run() {
 			if ( d_queue.size() > 1
 			     || d_done == false ) {
 				frameDropped = d_frameDropped.fetch_add(1) + 1;
+				if ( d_lossLedger ) {
+					d_lossLedger->Record(LossLedger::Stage::VideoOutput,frameID,"video output is late");
+				}
 				LOG(ERROR) << "[VideoOutput]: dropping frame " << frameID
 				           << " dropped: " << frameDropped
 				           << "/"
@@ -13,11 +13,15 @@
 namespace fort {
 namespace artemis {
 
+class LossLedger;
+typedef std::shared_ptr<LossLedger> LossLedgerPtr;
+
 class VideoOutputTask : public Task {
 public:
 	VideoOutputTask(const VideoOutputOptions & options,
 	                boost::asio::io_context & context,
-	                bool legacyMode);
+	                bool legacyMode,
+	                const LossLedgerPtr & lossLedger = LossLedgerPtr());
 
 	virtual ~VideoOutputTask();
 
@@ -71,6 +75,7 @@ private :
 	const bool d_legacyMode;
 
 	std::atomic<size_t> d_frameProcessed,d_frameDropped;
+	LossLedgerPtr       d_lossLedger;
 
 	std::vector<uint64_t> d_headerData;
 };
@@ -692,6 +692,7 @@ void GLUserInterface::DrawInformations(const DrawBuffer & buffer ) {
 	    << std::endl
 	    << printLine("Tags",OVERLAY_COLS,buffer.Frame.Message->tags_size()) << std::endl
 	    << printLine("Quads",OVERLAY_COLS,buffer.Frame.Message->quads()) << std::endl
+	    << printLine("Quality Level",OVERLAY_COLS,buffer.Frame.QualityLevel) << std::endl
 	    << std::endl
 	    << printLine("FPS",OVERLAY_COLS,buffer.Frame.FPS) << std::endl
 	    << printLine("Frame Processed",OVERLAY_COLS,buffer.Frame.FrameProcessed) << std::endl
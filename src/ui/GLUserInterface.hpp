@@ -140,7 +140,7 @@ private:
 	static const cv::Vec4f LABEL_BACKGROUND;
 
 	const static size_t OVERLAY_COLS = 30;
-	const static size_t OVERLAY_ROWS = 8;
+	const static size_t OVERLAY_ROWS = 9;
 	const static size_t NORMAL_POINT_SIZE = 70;
 	const static size_t HIGHLIGHTED_POINT_SIZE = 100;
 	const static size_t LABEL_FONT_SIZE = 16;
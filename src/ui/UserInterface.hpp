@@ -30,6 +30,7 @@ public:
 		size_t     FrameDropped;
 		size_t     VideoOutputProcessed;
 		size_t     VideoOutputDropped;
+		size_t     QualityLevel;
 	};
 
 	typedef tbb::concurrent_queue<cv::Rect> ROIChannel;
@@ -1,46 +1,52 @@
-#include "CPUMap.h"
+#include "CPUMap.hpp"
 
 #include <fstream>
 
-#include "PosixCall.h"
+#include "PosixCall.hpp"
 
 #include <map>
 #include <algorithm>
-#include "StringManipulation.h"
+#include "StringManipulation.hpp"
 
-std::vector<Core> GetCoreMap() {
-	std::ifstream cpuinfo("/proc/cpuinfo");
-	if ( cpuinfo.is_open() == false ) {
-		throw std::system_error(errno,ARTEMIS_SYSTEM_CATEGORY(),"Could not open cpuinfo: ");
-	}
+static size_t ParseValue(const std::string & line, const std::string & key) {
+	std::string a = line;
+	base::TrimPrefix(a, key);
+	base::TrimSpaces(a);
+	base::TrimPrefix(a, ":");
+	base::TrimSpaces(a);
+	return atoi(a.c_str());
+}
 
-	std::map<CoreID,Core> resInMap;
+std::vector<Core> ParseCoreMap(std::istream & cpuinfo) {
+	// core IDs are only unique within a package.
+	std::map<std::pair<PackageID,CoreID>,Core> resInMap;
 
-	CPUID cpu = -1;
+	const CPUID NONE = -1;
+	CPUID cpu = NONE;
+	PackageID package = 0;
 	for ( std::string line; getline(cpuinfo,line); ) {
 		if ( base::HasPrefix(line, "processor") ) {
-			std::string a = base::TrimPrefix(line, "processor");
-			a = base::TrimSpaces(a);
-			a = base::TrimPrefix(a, ":");
-			a = base::TrimSpaces(a);
-			cpu = atoi(a.c_str());
+			cpu = ParseValue(line,"processor");
+			package = 0;
+			continue;
+		}
+
+		if ( base::HasPrefix(line, "physical id") ) {
+			package = ParseValue(line,"physical id");
 			continue;
 		}
 
 		if ( base::HasPrefix(line, "core id") ) {
-			std::string a = base::TrimPrefix(line, "core id");
-			a = base::TrimSpaces(a);
-			a = base::TrimPrefix(a, ":");
-			a = base::TrimSpaces(a);
-			size_t coreid = atoi(a.c_str());
-			if (cpu == -1 ) {
+			size_t coreid = ParseValue(line,"core id");
+			if (cpu == NONE ) {
 				throw std::runtime_error("core id without processor");
 			}
-			if ( resInMap.count(coreid) == 0 ) {
-				resInMap[coreid] = Core{.ID=coreid};
+			auto key = std::make_pair(package,coreid);
+			if ( resInMap.count(key) == 0 ) {
+				resInMap[key] = Core{.ID=coreid,.Package = package};
 			}
-			resInMap[coreid].CPUs.push_back(cpu);
-			cpu = -1;
+			resInMap[key].CPUs.push_back(cpu);
+			cpu = NONE;
 			continue;
 		}
 	}
@@ -49,12 +55,16 @@ std::vector<Core> GetCoreMap() {
 	res.reserve(resInMap.size());
 	for( auto & kv : resInMap ) {
 		std::sort(kv.second.CPUs.begin(),kv.second.CPUs.end());
-
+		// the map is already sorted by package and ID.
 		res.push_back(kv.second);
-
 	}
-	std::sort(res.begin(),res.end(),[](const Core & a, const Core & b)->bool {
-			return a.ID < b.ID;
-		});
 	return res;
 }
+
+std::vector<Core> GetCoreMap() {
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	if ( cpuinfo.is_open() == false ) {
+		throw std::system_error(errno,ARTEMIS_SYSTEM_CATEGORY(),"Could not open cpuinfo: ");
+	}
+	return ParseCoreMap(cpuinfo);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <istream>
+
+typedef size_t CoreID;
+typedef size_t CPUID;
+typedef size_t PackageID;
+
+// A physical core, and the logical CPUs (SMT siblings) it runs.
+struct Core {
+	CoreID             ID;
+	// the processor package (socket), i.e. the NUMA node on the
+	// hosts we use.
+	PackageID          Package;
+	std::vector<CPUID> CPUs;
+};
+
+// Parses the content of /proc/cpuinfo. Cores are sorted by package
+// then ID, and CPUs of a core are sorted.
+std::vector<Core> ParseCoreMap(std::istream & cpuinfo);
+
+std::vector<Core> GetCoreMap();
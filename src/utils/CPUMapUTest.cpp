@@ -0,0 +1,47 @@
+#include "CPUMapUTest.hpp"
+
+#include "CPUMap.hpp"
+
+#include <sstream>
+
+TEST_F(CPUMapUTest,ParsesDualPackageWithSMT) {
+	// core IDs are repeated on each package, and siblings are not
+	// listed next to each other.
+	std::ostringstream cpuinfo;
+	std::vector<std::tuple<CPUID,PackageID,CoreID>> cpus = {
+		{0,0,0},{1,0,1},{2,1,0},{3,1,1},
+		{4,0,0},{5,0,1},{6,1,0},{7,1,1},
+	};
+	for ( const auto & [cpu,package,core] : cpus ) {
+		cpuinfo << "processor\t: " << cpu << std::endl
+		        << "model name\t: Some CPU" << std::endl
+		        << "physical id\t: " << package << std::endl
+		        << "siblings\t: 4" << std::endl
+		        << "core id\t\t: " << core << std::endl
+		        << "cpu cores\t: 2" << std::endl
+		        << std::endl;
+	}
+	std::istringstream input(cpuinfo.str());
+
+	auto cores = ParseCoreMap(input);
+	ASSERT_EQ(cores.size(),4);
+	std::vector<std::tuple<PackageID,CoreID,std::vector<CPUID>>> expected = {
+		{0,0,{0,4}},
+		{0,1,{1,5}},
+		{1,0,{2,6}},
+		{1,1,{3,7}},
+	};
+	for ( size_t i = 0; i < cores.size(); ++i ) {
+		const auto & [package,ID,CPUs] = expected[i];
+		EXPECT_EQ(cores[i].Package,package);
+		EXPECT_EQ(cores[i].ID,ID);
+		EXPECT_EQ(cores[i].CPUs,CPUs);
+	}
+}
+
+TEST_F(CPUMapUTest,ReadsHostMap) {
+	auto cores = GetCoreMap();
+	for ( const auto & core : cores ) {
+		EXPECT_FALSE(core.CPUs.empty());
+	}
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+class CPUMapUTest : public testing::Test {
+protected:
+
+};
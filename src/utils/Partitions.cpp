@@ -1,5 +1,9 @@
 #include "Partitions.hpp"
 
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
 
 
 void PartitionInTwo(const cv::Rect & rect,size_t partitions, cv::Rect & a, cv::Rect & b) {
@@ -39,6 +43,43 @@ void PartitionRectangle(const cv::Rect & rect, size_t partitions, Partition & re
 	PartitionRectangle(b,partitions/2,results);
 }
 
+void TileRectangle(const cv::Rect & rect, size_t tileSize, Partition & results) {
+	if ( tileSize == 0 || rect.area() <= 0 ) {
+		return;
+	}
+	int cols = (rect.width + tileSize - 1) / tileSize;
+	int rows = (rect.height + tileSize - 1) / tileSize;
+	for ( int y = 0; y < rows; ++y ) {
+		int top = rect.y + (rect.height * y) / rows;
+		int bottom = rect.y + (rect.height * (y + 1)) / rows;
+		for ( int x = 0; x < cols; ++x ) {
+			int left = rect.x + (rect.width * x) / cols;
+			int right = rect.x + (rect.width * (x + 1)) / cols;
+			results.push_back(cv::Rect(left,top,right-left,bottom-top));
+		}
+	}
+}
+
+void CropToMask(const cv::Mat & mask, Partition & partitions) {
+	if ( mask.empty() ) {
+		return;
+	}
+	auto bounds = cv::Rect(cv::Point(0,0),mask.size());
+	Partition::iterator last = partitions.begin();
+	for ( const auto & p : partitions ) {
+		auto roi = p & bounds;
+		if ( roi.area() <= 0 ) {
+			continue;
+		}
+		auto cropped = cv::boundingRect(mask(roi));
+		if ( cropped.area() <= 0 ) {
+			continue;
+		}
+		*last = cropped + roi.tl();
+		++last;
+	}
+	partitions.erase(last,partitions.end());
+}
 
 void AddMargin(const cv::Size & size, size_t margin, Partition & partitions) {
 	for ( auto & p : partitions ) {
@@ -69,3 +110,91 @@ void AddMargin(const cv::Size & size, size_t margin, Partition & partitions) {
 		}
 	}
 }
+
+
+void ComputeNeighbours(const Partition & partition,
+                       PartitionNeighbours & neighbours,
+                       NeighbourGrid & grid) {
+	neighbours.resize(partition.size());
+	for ( auto & n : neighbours ) {
+		n.clear();
+	}
+	if ( partition.size() < 2 ) {
+		return;
+	}
+
+	cv::Rect bounds = partition.front();
+	int64_t widths(0),heights(0);
+	for ( const auto & p : partition ) {
+		bounds |= p;
+		widths += p.width;
+		heights += p.height;
+	}
+	int cellWidth = std::max(int(widths / int64_t(partition.size())),1);
+	int cellHeight = std::max(int(heights / int64_t(partition.size())),1);
+	int cols = bounds.width / cellWidth + 1;
+	int rows = bounds.height / cellHeight + 1;
+
+	auto forEachCell = [&](const cv::Rect & r, auto && f) {
+		                   for ( int y = (r.y - bounds.y) / cellHeight; y <= (r.y + r.height - 1 - bounds.y) / cellHeight; ++y ) {
+			                   for ( int x = (r.x - bounds.x) / cellWidth; x <= (r.x + r.width - 1 - bounds.x) / cellWidth; ++x ) {
+				                   f(size_t(y * cols + x));
+			                   }
+		                   }
+	                   };
+
+	// counts, then fills the items of each cell, in increasing
+	// element order.
+	grid.Start.assign(cols * rows + 1,0);
+	for ( const auto & p : partition ) {
+		if ( p.area() <= 0 ) {
+			continue;
+		}
+		forEachCell(p,[&grid](size_t c) { ++grid.Start[c+1]; });
+	}
+	for ( size_t c = 1; c < grid.Start.size(); ++c ) {
+		grid.Start[c] += grid.Start[c-1];
+	}
+	grid.Items.resize(grid.Start.back());
+	for ( size_t i = 0; i < partition.size(); ++i ) {
+		if ( partition[i].area() <= 0 ) {
+			continue;
+		}
+		forEachCell(partition[i],[&grid,i](size_t c) { grid.Items[grid.Start[c]++] = i; });
+	}
+	// filling moved each start to the next cell start.
+	for ( size_t c = grid.Start.size() - 1; c > 0; --c ) {
+		grid.Start[c] = grid.Start[c-1];
+	}
+	grid.Start[0] = 0;
+
+	for ( size_t c = 0; c + 1 < grid.Start.size(); ++c ) {
+		for ( size_t a = grid.Start[c]; a < grid.Start[c+1]; ++a ) {
+			size_t i = grid.Items[a];
+			for ( size_t b = a + 1; b < grid.Start[c+1]; ++b ) {
+				size_t j = grid.Items[b];
+				auto overlap = partition[i] & partition[j];
+				if ( overlap.area() <= 0 ) {
+					continue;
+				}
+				// a pair shares every cell of its overlap, it is only
+				// listed in the one of the overlap top-left corner.
+				size_t corner = size_t(((overlap.y - bounds.y) / cellHeight) * cols
+				                       + (overlap.x - bounds.x) / cellWidth);
+				if ( corner != c ) {
+					continue;
+				}
+				neighbours[i].push_back(j);
+				neighbours[j].push_back(i);
+			}
+		}
+	}
+	for ( auto & n : neighbours ) {
+		std::sort(n.begin(),n.end());
+	}
+}
+
+void ComputeNeighbours(const Partition & partition, PartitionNeighbours & neighbours) {
+	NeighbourGrid grid;
+	ComputeNeighbours(partition,neighbours,grid);
+}
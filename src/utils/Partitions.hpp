@@ -6,9 +6,36 @@
 
 typedef std::vector<cv::Rect> Partition;
 
+typedef std::vector<std::vector<size_t>> PartitionNeighbours;
+
 
 void PartitionRectangle(const cv::Rect & rect, size_t partitions, Partition & result);
 
 void PartitionImage(const cv::Mat & img, size_t partitions, Partition & result);
 
+void TileRectangle(const cv::Rect & rect, size_t tileSize, Partition & result);
+
+// Crops each element of the partition to the bounding box of the
+// non-zero pixels of mask it contains, and removes the ones without
+// any.
+void CropToMask(const cv::Mat & mask, Partition & result);
+
 void AddMargin(const cv::Size & maxSize, size_t margin, Partition & result);
+
+// Storage reused by ComputeNeighbours between calls: the elements of
+// the partition are bucketed in a grid, in a compressed row layout.
+struct NeighbourGrid {
+	std::vector<size_t> Start;
+	std::vector<size_t> Items;
+};
+
+// Lists for each element of the partition the other elements it
+// overlaps with, in increasing order. Only elements sharing a cell of
+// a grid of the size of an average element are compared, so the cost
+// stays close to linear. Inner vectors and the grid are reused to
+// avoid allocation.
+void ComputeNeighbours(const Partition & partition,
+                       PartitionNeighbours & neighbours,
+                       NeighbourGrid & grid);
+
+void ComputeNeighbours(const Partition & partition, PartitionNeighbours & neighbours);
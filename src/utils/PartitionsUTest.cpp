@@ -70,6 +70,61 @@ TEST_F(PartitionsUTest,PartitionEqually) {
 
 }
 
+TEST_F(PartitionsUTest,Tiling) {
+	struct TestData {
+		cv::Rect  Base;
+		size_t    TileSize;
+		Partition Expected;
+	};
+
+	std::vector<TestData> testdata = {
+		{
+			.Base = cv::Rect(0,0,200,100),
+			.TileSize = 200,
+			.Expected = {
+				cv::Rect(0,0,200,100),
+			},
+		},
+		{
+			.Base = cv::Rect(0,0,200,100),
+			.TileSize = 60,
+			.Expected = {
+				cv::Rect(0,0,50,50),
+				cv::Rect(50,0,50,50),
+				cv::Rect(100,0,50,50),
+				cv::Rect(150,0,50,50),
+				cv::Rect(0,50,50,50),
+				cv::Rect(50,50,50,50),
+				cv::Rect(100,50,50,50),
+				cv::Rect(150,50,50,50),
+			},
+		},
+		{
+			.Base = cv::Rect(10,20,100,50),
+			.TileSize = 40,
+			.Expected = {
+				cv::Rect(10,20,33,25),
+				cv::Rect(43,20,33,25),
+				cv::Rect(76,20,34,25),
+				cv::Rect(10,45,33,25),
+				cv::Rect(43,45,33,25),
+				cv::Rect(76,45,34,25),
+			},
+		},
+	};
+
+	for( auto const & d : testdata ) {
+		Partition res;
+		TileRectangle(d.Base, d.TileSize, res);
+
+		EXPECT_EQ(res.size(),d.Expected.size());
+
+		for (size_t i = 0; i < std::min(res.size(),d.Expected.size()); ++i ) {
+			EXPECT_EQ(res[i],d.Expected[i]);
+		}
+	}
+}
+
 
 TEST_F(PartitionsUTest,MarginAdding) {
 	struct TestData {
@@ -113,3 +168,82 @@ TEST_F(PartitionsUTest,MarginAdding) {
 		}
 	}
 }
+
+
+TEST_F(PartitionsUTest,Neighbours) {
+	Partition partition = {
+		cv::Rect(0,0,45,100),
+		cv::Rect(35,0,90,55),
+		cv::Rect(35,45,90,55),
+		cv::Rect(115,0,85,55),
+		cv::Rect(125,45,75,55),
+	};
+	PartitionNeighbours expected = {
+		{1,2},
+		{0,2,3},
+		{0,1,3},
+		{1,2,4},
+		{3},
+	};
+
+	// reuses previous result
+	PartitionNeighbours res = {{4,3,2},{},{1}};
+	ComputeNeighbours(partition,res);
+	EXPECT_EQ(res,expected);
+}
+
+TEST_F(PartitionsUTest,NeighboursOfManyWindows) {
+	// overlapping windows of different sizes, as tracking produces.
+	Partition partition;
+	for ( int y = 0; y < 20; ++y ) {
+		for ( int x = 0; x < 20; ++x ) {
+			if ( (x * 7 + y * 3) % 4 == 0 ) {
+				continue;
+			}
+			partition.push_back(cv::Rect(x * 50,y * 50,66 + (x % 3) * 40,66));
+		}
+	}
+	PartitionNeighbours expected(partition.size());
+	for ( size_t i = 0; i < partition.size(); ++i ) {
+		for ( size_t j = 0; j < partition.size(); ++j ) {
+			if ( i != j && (partition[i] & partition[j]).area() > 0 ) {
+				expected[i].push_back(j);
+			}
+		}
+	}
+
+	PartitionNeighbours res;
+	NeighbourGrid grid;
+	ComputeNeighbours(partition,res,grid);
+	EXPECT_EQ(res,expected);
+	// the grid is reused.
+	ComputeNeighbours(partition,res,grid);
+	EXPECT_EQ(res,expected);
+}
+
+TEST_F(PartitionsUTest,CropToMask) {
+	cv::Mat mask(100,200,CV_8UC1,cv::Scalar(0));
+	mask(cv::Rect(30,20,60,10)).setTo(255);
+	mask(cv::Rect(150,90,5,5)).setTo(255);
+
+	Partition partition = {
+		cv::Rect(0,0,100,50),
+		cv::Rect(100,0,100,50),
+		cv::Rect(0,50,100,50),
+		cv::Rect(100,50,100,50),
+		cv::Rect(50,0,100,100),
+	};
+	Partition expected = {
+		cv::Rect(30,20,60,10),
+		cv::Rect(150,90,5,5),
+		cv::Rect(50,20,40,10),
+	};
+
+	CropToMask(mask,partition);
+	EXPECT_EQ(partition,expected);
+
+	// an empty mask keeps everything
+	partition = {cv::Rect(0,0,100,50)};
+	CropToMask(cv::Mat(),partition);
+	EXPECT_EQ(partition,Partition({cv::Rect(0,0,100,50)}));
+}
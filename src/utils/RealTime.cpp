@@ -0,0 +1,39 @@
+#include "RealTime.hpp"
+
+#include "PosixCall.hpp"
+
+#include <alloca.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <cstring>
+
+void LockProcessMemory() {
+	p_call(mlockall,MCL_CURRENT | MCL_FUTURE);
+	// freed memory stays in the heap, and large blocks are not
+	// mmaped, so they are never faulted in again. This only tunes
+	// glibc malloc: the tbbmalloc proxy ignores mallopt, and memory
+	// it maps later is still populated at mmap time by MCL_FUTURE.
+	mallopt(M_TRIM_THRESHOLD,-1);
+	mallopt(M_MMAP_MAX,0);
+}
+
+void SetRealTimeScheduling(int policy, int priority) {
+	struct sched_param param;
+	std::memset(&param,0,sizeof(param));
+	param.sched_priority = priority;
+	int err = pthread_setschedparam(pthread_self(),policy,&param);
+	if ( err != 0 ) {
+		throw ARTEMIS_SYSTEM_ERROR(pthread_setschedparam,err);
+	}
+}
+
+void PrefaultStack(size_t size) {
+	// volatile, so the compiler cannot remove the writes.
+	volatile char * stack = reinterpret_cast<volatile char*>(alloca(size));
+	for ( size_t i = 0; i < size; i += 4096 ) {
+		stack[i] = 0;
+	}
+}
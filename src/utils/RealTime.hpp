@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+// Locks all current and future pages of the process in RAM, which
+// also faults them in, and keeps malloc from giving memory back to
+// the system, so real-time threads never wait on a page fault. The
+// latter only applies to glibc malloc, not to the tbbmalloc proxy
+// (USE_TBB_MALLOC_PROXY), whose new pages are locked and faulted
+// in when mapped.
+void LockProcessMemory();
+
+// Puts the calling thread under a real-time scheduling policy
+// (SCHED_FIFO or SCHED_RR). Throws std::system_error, e.g. without
+// CAP_SYS_NICE or a real-time rlimit.
+void SetRealTimeScheduling(int policy, int priority);
+
+// Touches size bytes of the calling thread stack.
+void PrefaultStack(size_t size);